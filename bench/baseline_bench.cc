@@ -0,0 +1,186 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <vector>
+
+#include "tests/timestamp_node.h"
+#include "cpu_topology.h"
+#include "bench_main.h"
+
+// The same operation mix on Lock_free_list and on std::list behind a
+// std::mutex, a std::shared_mutex and a spinlock, from 1 to 64 threads, to
+// show where lock-freedom starts to pay off. The std::list baselines
+// allocate on push_back as their users would; Lock_free_list takes nodes
+// from a per-thread pool that pop_front() refills, since it leaves memory
+// to the caller.
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+static inline void cpu_relax() noexcept { _mm_pause(); }
+#else
+static inline void cpu_relax() noexcept {}
+#endif
+
+// Test and test-and-set
+class Spinlock {
+public:
+    void lock() noexcept {
+        while (m_locked.exchange(true, std::memory_order_acquire)) {
+            while (m_locked.load(std::memory_order_relaxed)) {
+                cpu_relax();
+            }
+        }
+    }
+
+    void unlock() noexcept {
+        m_locked.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> m_locked{false};
+};
+
+// std::list<int> behind Lock, find() takes a shared lock if Lock has one
+template<typename Lock>
+class Locked_list {
+public:
+    explicit Locked_list(int) {}
+
+    void push_back(int, int value) {
+        std::lock_guard guard(m_lock);
+        m_list.push_back(value);
+    }
+
+    bool pop_front(int) {
+        std::lock_guard guard(m_lock);
+        if (m_list.empty()) {
+            return false;
+        }
+        m_list.pop_front();
+        return true;
+    }
+
+    bool find(int value) {
+        if constexpr (requires(Lock& lock) { lock.lock_shared(); }) {
+            std::shared_lock guard(m_lock);
+            return std::find(m_list.begin(), m_list.end(), value) != m_list.end();
+        } else {
+            std::lock_guard guard(m_lock);
+            return std::find(m_list.begin(), m_list.end(), value) != m_list.end();
+        }
+    }
+
+private:
+    Lock m_lock;
+    std::list<int> m_list;
+};
+
+class Lock_free_adapter {
+public:
+    explicit Lock_free_adapter(int threads) : m_pools(threads) {}
+
+    void push_back(int t, int value) {
+        auto& pool = m_pools[t];
+
+        if (pool.m_free.empty()) {
+            pool.m_owned.push_back(std::make_unique<DataNode>(0));
+            pool.m_free.push_back(pool.m_owned.back().get());
+        }
+
+        auto node = pool.m_free.back();
+        pool.m_free.pop_back();
+        node->m_value = value;
+        m_list.push_back(node);
+    }
+
+    bool pop_front(int t) {
+        auto node = m_list.pop_front();
+
+        if (node == nullptr) {
+            return false;
+        }
+        m_pools[t].m_free.push_back(static_cast<DataNode*>(node));
+        return true;
+    }
+
+    bool find(int value) {
+        return m_list.find(value) != nullptr;
+    }
+
+private:
+    struct alignas(64) Pool {
+        std::vector<DataNode*> m_free;
+        std::vector<std::unique_ptr<DataNode>> m_owned;
+    };
+
+    ut::Lock_free_list<DataNode> m_list;
+    std::vector<Pool> m_pools;
+};
+
+// Percent of finds and of push_backs, the rest are pop_fronts
+struct Baseline_mix {
+    int m_find;
+    int m_push_back;
+};
+
+static constexpr std::array<Baseline_mix, 3> baseline_mixes{{
+    {90, 5},    // read mostly
+    {50, 25},   // balanced
+    {0, 50},    // queue
+}};
+
+static constexpr int preload = 256;
+
+// Mix state.range(0) from state.threads() threads on a list of about
+// preload values. Thread 0 builds the list before the timing loop.
+template<typename List>
+static void BM_Baseline(benchmark::State& state) {
+    static std::unique_ptr<List> list;
+    const auto& mix = baseline_mixes[state.range(0)];
+    const int t = state.thread_index();
+
+    if (t == 0) {
+        list = std::make_unique<List>(state.threads());
+        for (int i = 0; i < preload; ++i) {
+            list->push_back(0, i);
+        }
+    }
+
+    bench::Pin_scope pin(t);
+    std::mt19937 rng(t + 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> value(0, 2 * preload - 1);
+
+    for (auto _ : state) {
+        const int p = percent(rng);
+
+        if (p < mix.m_find) {
+            benchmark::DoNotOptimize(list->find(value(rng)));
+        } else if (p < mix.m_find + mix.m_push_back) {
+            list->push_back(t, value(rng));
+        } else {
+            benchmark::DoNotOptimize(list->pop_front(t));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (t == 0) {
+        list.reset();
+    }
+}
+
+#define BASELINE(List) \
+    BENCHMARK_TEMPLATE(BM_Baseline, List)->ArgName("mix")->DenseRange(0, 2)->ThreadRange(1, 64)->UseRealTime()
+
+BASELINE(Lock_free_adapter);
+BASELINE(Locked_list<std::mutex>);
+BASELINE(Locked_list<std::shared_mutex>);
+BASELINE(Locked_list<Spinlock>);
+
+LOCKFREELIST_BENCH_MAIN();
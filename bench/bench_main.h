@@ -0,0 +1,129 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <bit>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "lockfreelist.h"
+#include "cpu_topology.h"
+
+// Build and machine details for the "context" section of the JSON output
+// (--benchmark_out=run.json --benchmark_out_format=json), so two runs can be
+// compared knowing what produced them. CMake passes the build type and
+// flags, other builds report "unknown".
+
+#ifndef LOCKFREELIST_BUILD_TYPE
+#define LOCKFREELIST_BUILD_TYPE "unknown"
+#endif
+
+#ifndef LOCKFREELIST_CXX_FLAGS
+#define LOCKFREELIST_CXX_FLAGS "unknown"
+#endif
+
+namespace bench {
+
+inline std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+
+    while (std::getline(cpuinfo, line)) {
+        if (line.starts_with("model name")) {
+            if (auto colon = line.find(':'); colon != std::string::npos) {
+                return line.substr(line.find_first_not_of(' ', colon + 1));
+            }
+        }
+    }
+    return "unknown";
+}
+
+inline std::string compiler() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+inline void add_build_context() {
+    using Tag = ut::Node::Tag;
+
+    benchmark::AddCustomContext("cpu_model", cpu_model());
+    benchmark::AddCustomContext("cpu_cores", std::to_string(std::thread::hardware_concurrency()));
+    benchmark::AddCustomContext("compiler", compiler());
+    benchmark::AddCustomContext("build_type", LOCKFREELIST_BUILD_TYPE);
+    benchmark::AddCustomContext("cxx_flags", LOCKFREELIST_CXX_FLAGS);
+
+#if defined(__OPTIMIZE__)
+    benchmark::AddCustomContext("optimized", "yes");
+#else
+    benchmark::AddCustomContext("optimized", "no");
+#endif
+
+#if defined(NDEBUG)
+    benchmark::AddCustomContext("asserts", "off");
+#else
+    benchmark::AddCustomContext("asserts", "on");
+#endif
+
+#if defined(LOCKFREELIST_USDT)
+    benchmark::AddCustomContext("usdt", "on");
+#else
+    benchmark::AddCustomContext("usdt", "off");
+#endif
+
+    const auto& topology = Cpu_topology::get();
+    benchmark::AddCustomContext("topology",
+        std::to_string(topology.packages()) + " sockets, " + std::to_string(topology.cores()) + " cores, " +
+        std::to_string(topology.cpus().size()) + " cpus");
+    benchmark::AddCustomContext("pinning", name(pinning()));
+
+    benchmark::AddCustomContext("tag_mode",
+        std::to_string(std::popcount(Tag::version_mask)) + " version bits in " +
+        std::to_string(alignof(ut::Node)) + " byte aligned node pointers");
+}
+
+// Take --pin=<policy> out of argv before Google Benchmark sees it
+inline bool parse_pin_flag(int& argc, char** argv) {
+    const std::string flag = "--pin=";
+    int out = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+
+        if (!arg.starts_with(flag)) {
+            argv[out++] = argv[i];
+        } else if (!parse_pinning(arg.substr(flag.size()), pinning())) {
+            std::cerr << "unknown pinning " << arg.substr(flag.size())
+                      << ", use none, compact, scatter, smt or cross_socket" << std::endl;
+            return false;
+        }
+    }
+    argv[out] = nullptr;
+    argc = out;
+    return true;
+}
+
+} // namespace bench
+
+// BENCHMARK_MAIN() that also takes --pin=<policy> and records the build
+// context
+#define LOCKFREELIST_BENCH_MAIN()                                   \
+    int main(int argc, char** argv) {                               \
+        if (!bench::parse_pin_flag(argc, argv)) {                   \
+            return 1;                                               \
+        }                                                           \
+        bench::add_build_context();                                 \
+        benchmark::Initialize(&argc, argv);                         \
+        if (benchmark::ReportUnrecognizedArguments(argc, argv)) {   \
+            return 1;                                               \
+        }                                                           \
+        benchmark::RunSpecifiedBenchmarks();                        \
+        benchmark::Shutdown();                                      \
+        return 0;                                                   \
+    }                                                               \
+    int main(int, char**)
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <sched.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "numa_list.h"
+
+namespace bench {
+
+// Where benchmark threads run. Thread t of a benchmark gets the t-th CPU
+// of the policy's order, wrapping around past the last CPU.
+//
+//  none          the OS places threads, the default
+//  compact       one thread per core, filling a socket before the next,
+//                SMT siblings only once every core has a thread
+//  scatter       one thread per core, round robin over the sockets, SMT
+//                siblings last
+//  smt           both hardware threads of a core before the next core, so
+//                neighbouring threads share L1 and L2
+//  cross_socket  alternate between the first and the last socket, so
+//                neighbouring threads always talk over the interconnect;
+//                the same as scatter on one socket
+enum class Pinning { none, compact, scatter, smt, cross_socket };
+
+inline const char* name(Pinning pinning) {
+    switch (pinning) {
+        case Pinning::compact: return "compact";
+        case Pinning::scatter: return "scatter";
+        case Pinning::smt: return "smt";
+        case Pinning::cross_socket: return "cross_socket";
+        default: return "none";
+    }
+}
+
+inline bool parse_pinning(const std::string& text, Pinning& pinning) {
+    for (auto p : {Pinning::none, Pinning::compact, Pinning::scatter, Pinning::smt, Pinning::cross_socket}) {
+        if (text == name(p)) {
+            pinning = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+// CPUs this process may run on with their core, socket and NUMA node, read
+// from /sys/devices/system/cpu once. The affinity mask is read when the
+// topology is first used, so call get() before pinning anything.
+class Cpu_topology {
+public:
+    struct Cpu {
+        int m_id;
+        int m_core;
+        int m_package;
+        int m_node;
+
+        // Index of this hardware thread among its core's siblings
+        int m_smt;
+    };
+
+    static const Cpu_topology& get() {
+        static const Cpu_topology topology;
+        return topology;
+    }
+
+    const std::vector<Cpu>& cpus() const noexcept {
+        return m_cpus;
+    }
+
+    int packages() const noexcept {
+        return m_packages;
+    }
+
+    int cores() const noexcept {
+        return m_cores;
+    }
+
+    // CPU ids in the order policy hands them to threads, empty for none
+    const std::vector<int>& order(Pinning pinning) const noexcept {
+        return m_orders[size_t(pinning)];
+    }
+
+    Cpu_topology(const Cpu_topology&) = delete;
+    Cpu_topology& operator=(const Cpu_topology&) = delete;
+
+private:
+    std::vector<int> make_order(Pinning pinning) const {
+        auto cpus = m_cpus;
+
+        switch (pinning) {
+            case Pinning::none:
+                return {};
+            case Pinning::compact:
+                sort_by(cpus, [](const Cpu& cpu) { return std::tuple(cpu.m_smt, cpu.m_package, cpu.m_core, cpu.m_id); });
+                break;
+            case Pinning::smt:
+                sort_by(cpus, [](const Cpu& cpu) { return std::tuple(cpu.m_package, cpu.m_core, cpu.m_smt, cpu.m_id); });
+                break;
+            case Pinning::scatter:
+            case Pinning::cross_socket: {
+                // Rank of each CPU's core within its socket, so sockets take turns
+                std::vector<int> rank(cpus.size());
+                sort_by(cpus, [](const Cpu& cpu) { return std::tuple(cpu.m_package, cpu.m_core, cpu.m_smt, cpu.m_id); });
+
+                for (size_t i = 0, r = 0; i < cpus.size(); ++i) {
+                    if (i > 0 && cpus[i].m_package != cpus[i - 1].m_package) {
+                        r = 0;
+                    } else if (i > 0 && cpus[i].m_core != cpus[i - 1].m_core) {
+                        ++r;
+                    }
+                    rank[i] = int(r);
+                }
+
+                std::vector<std::tuple<int, int, int, int>> keys;
+                for (size_t i = 0; i < cpus.size(); ++i) {
+                    keys.emplace_back(cpus[i].m_smt, rank[i], cpus[i].m_package, cpus[i].m_id);
+                }
+                std::sort(keys.begin(), keys.end());
+
+                std::vector<int> ids;
+                const int first = cpus.front().m_package;
+                const int last = cpus.back().m_package;
+
+                for (const auto& [smt, r, package, id] : keys) {
+                    if (pinning == Pinning::scatter || package == first || package == last) {
+                        ids.push_back(id);
+                    }
+                }
+                return ids;
+            }
+        }
+
+        std::vector<int> ids;
+        for (const auto& cpu : cpus) {
+            ids.push_back(cpu.m_id);
+        }
+        return ids;
+    }
+
+    Cpu_topology() {
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                CPU_SET(cpu, &allowed);
+            }
+        }
+
+        const auto& numa = ut::numa::Topology::get();
+        auto online = ut::numa::parse_list(ut::numa::read_line("/sys/devices/system/cpu/online"));
+
+        if (online.empty()) {
+            for (size_t cpu = 0; cpu < numa.m_cpu_node.size(); ++cpu) {
+                online.push_back(int(cpu));
+            }
+        }
+
+        for (auto id : online) {
+            if (id >= CPU_SETSIZE || !CPU_ISSET(id, &allowed)) {
+                continue;
+            }
+
+            const auto dir = "/sys/devices/system/cpu/cpu" + std::to_string(id) + "/topology/";
+            const auto core = read_int(dir + "core_id", id);
+            const auto package = read_int(dir + "physical_package_id", 0);
+
+            m_cpus.push_back({id, core, package, numa.node_of_cpu(id), 0});
+        }
+
+        // Number the SMT siblings of every core, count cores and sockets
+        sort_by(m_cpus, [](const Cpu& cpu) { return std::tuple(cpu.m_package, cpu.m_core, cpu.m_id); });
+
+        for (size_t i = 0; i < m_cpus.size(); ++i) {
+            const bool same_core = i > 0 && m_cpus[i].m_package == m_cpus[i - 1].m_package && m_cpus[i].m_core == m_cpus[i - 1].m_core;
+
+            m_cpus[i].m_smt = same_core ? m_cpus[i - 1].m_smt + 1 : 0;
+            m_cores += !same_core;
+            m_packages += i == 0 || m_cpus[i].m_package != m_cpus[i - 1].m_package;
+        }
+
+        for (size_t i = 0; i < m_orders.size(); ++i) {
+            m_orders[i] = make_order(Pinning(i));
+        }
+    }
+
+    template<typename Key>
+    static void sort_by(std::vector<Cpu>& cpus, Key key) {
+        std::sort(cpus.begin(), cpus.end(), [&key](const Cpu& a, const Cpu& b) { return key(a) < key(b); });
+    }
+
+    static int read_int(const std::string& path, int fallback) {
+        const auto line = ut::numa::read_line(path);
+        return line.empty() ? fallback : std::stoi(line);
+    }
+
+    std::vector<Cpu> m_cpus;
+    std::array<std::vector<int>, 5> m_orders;
+    int m_cores{};
+    int m_packages{};
+};
+
+// Policy for this run, LOCKFREELIST_BENCH_MAIN() sets it from --pin=
+inline Pinning& pinning() {
+    static Pinning policy = Pinning::none;
+    return policy;
+}
+
+// Pins the calling thread as thread t of the policy for its lifetime and
+// gives it back its previous affinity after, for benchmark threads that
+// live on, like Google Benchmark's own. fallback applies if no policy was
+// chosen on the command line.
+class Pin_scope {
+public:
+    explicit Pin_scope(int t, Pinning fallback = Pinning::none) {
+        const auto policy = pinning() == Pinning::none ? fallback : pinning();
+        const auto& order = Cpu_topology::get().order(policy);
+
+        if (order.empty() || sched_getaffinity(0, sizeof(m_saved), &m_saved) != 0) {
+            return;
+        }
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(order[t % order.size()], &set);
+        m_pinned = sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+    ~Pin_scope() {
+        if (m_pinned) {
+            sched_setaffinity(0, sizeof(m_saved), &m_saved);
+        }
+    }
+
+    Pin_scope(const Pin_scope&) = delete;
+    Pin_scope& operator=(const Pin_scope&) = delete;
+
+private:
+    cpu_set_t m_saved;
+    bool m_pinned{};
+};
+
+// Threads for one timed region. add() starts a thread, pins it and waits
+// until it is parked, start() lets them all run. Create and add them with
+// timing paused, then resume timing around start() and join(), so thread
+// creation and the pinning syscalls stay out of the measurement.
+class Pinned_threads {
+public:
+    Pinned_threads() = default;
+
+    ~Pinned_threads() {
+        start();
+        join();
+    }
+
+    // Run fn() pinned as thread t of the policy once start() is called
+    template<typename Fn>
+    void add(int t, Fn fn, Pinning fallback = Pinning::none) {
+        std::atomic<bool> parked{false};
+
+        m_threads.emplace_back([this, t, fallback, &parked, fn = std::move(fn)]() mutable {
+            Pin_scope pin(t, fallback);
+            parked.store(true, std::memory_order_release);
+            m_go.wait(false, std::memory_order_acquire);
+            fn();
+        });
+        while (!parked.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void start() {
+        m_go.store(true, std::memory_order_release);
+        m_go.notify_all();
+    }
+
+    void join() {
+        for (auto& thread : m_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    Pinned_threads(const Pinned_threads&) = delete;
+    Pinned_threads& operator=(const Pinned_threads&) = delete;
+
+private:
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_go{false};
+};
+
+} // namespace bench
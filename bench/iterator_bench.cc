@@ -5,8 +5,12 @@
 #include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include <numeric>
 
 #include "tests/timestamp_node.h"
+#include "perf_counters.h"
+#include "cpu_topology.h"
+#include "bench_main.h"
 
 // Utility function to populate list
 template<typename T>
@@ -31,6 +35,7 @@ static void BM_IteratorForward(benchmark::State& state) {
     ut::Lock_free_list<TimestampNode> list;
     populate_list(list, state.range(0));
     
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         int sum = 0;
         for (const auto& node : list) {
@@ -51,6 +56,7 @@ static void BM_IteratorReverse(benchmark::State& state) {
     ut::Lock_free_list<TimestampNode> list;
     populate_list(list, state.range(0));
     
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         int sum = 0;
         for (auto it = list.rbegin(); it != list.rend(); --it) {
@@ -79,6 +85,7 @@ static void BM_IteratorRandomAccess(benchmark::State& state) {
     std::mt19937 gen(rd());
     std::shuffle(indices.begin(), indices.end(), gen);
     
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         int sum = 0;
         for (size_t idx : indices) {
@@ -103,8 +110,10 @@ static void BM_IteratorConcurrentModification(benchmark::State& state) {
     std::atomic<bool> stop_flag{false};
     std::atomic<size_t> total_iterations{0};
     
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         stop_flag.store(false);
         total_iterations.store(0);
         
@@ -129,6 +138,7 @@ static void BM_IteratorConcurrentModification(benchmark::State& state) {
             }
         });
         
+        perf.resume();
         state.ResumeTiming();
         
         // Measure iteration performance
@@ -139,8 +149,10 @@ static void BM_IteratorConcurrentModification(benchmark::State& state) {
         }
         
         state.PauseTiming();
+        perf.pause();
         stop_flag.store(true);
         modifier.join();
+        perf.resume();
         state.ResumeTiming();
         
         benchmark::ClobberMemory();
@@ -161,17 +173,17 @@ static void BM_MultipleConcurrentIterators(benchmark::State& state) {
     std::atomic<bool> stop_flag{false};
     std::atomic<size_t> total_iterations{0};
     
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         stop_flag.store(false);
         total_iterations.store(0);
-        std::vector<std::thread> threads;
-        
-        state.ResumeTiming();
-        
-        // Create multiple iterator threads
+
+        // Multiple iterator threads, started and pinned before the clock runs
+        bench::Pinned_threads threads;
         for (int t = 0; t < num_threads; ++t) {
-            threads.emplace_back([&]() {
+            threads.add(t, [&]() {
                 while (!stop_flag.load()) {
                     int sum = 0;
                     for (const auto& node : list) {
@@ -182,15 +194,19 @@ static void BM_MultipleConcurrentIterators(benchmark::State& state) {
                 }
             });
         }
-        
+
+        perf.resume();
+        state.ResumeTiming();
+        threads.start();
+
         // Let them run for a while
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
         
         state.PauseTiming();
+        perf.pause();
         stop_flag.store(true);
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        threads.join();
+        perf.resume();
         state.ResumeTiming();
     }
     
@@ -205,6 +221,7 @@ static void BM_IteratorCreation(benchmark::State& state) {
     ut::Lock_free_list<TimestampNode> list;
     populate_list(list, state.range(0));
     
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         auto it = list.begin();
         benchmark::DoNotOptimize(it);
@@ -219,9 +236,11 @@ BENCHMARK(BM_IteratorCreation)
 
 // Compare iterator vs direct pointer traversal
 static void BM_IteratorVsPointer(benchmark::State& state) {
+    bench::Pin_scope pin(state.thread_index());
     ut::Lock_free_list<TimestampNode> list;
     populate_list(list, state.range(0));
     
+    bench::Perf_scope perf(state, "iterator", "pointer");
     if (state.thread_index() == 0) {
         // Iterator traversal
         for (auto _ : state) {
@@ -254,11 +273,13 @@ BENCHMARK(BM_IteratorVsPointer)
 
 // Find with iterator vs find method
 static void BM_FindComparison(benchmark::State& state) {
+    bench::Pin_scope pin(state.thread_index());
     ut::Lock_free_list<TimestampNode> list;
     populate_list(list, state.range(0));
     
     const int target_value = state.range(0) / 2;
     
+    bench::Perf_scope perf(state, "find_if", "find");
     if (state.thread_index() == 0) {
         // Using iterator
         for (auto _ : state) {
@@ -285,9 +306,11 @@ BENCHMARK(BM_FindComparison)
 
 // Cache-friendly iteration pattern
 static void BM_CacheFriendlyIteration(benchmark::State& state) {
+    bench::Pin_scope pin(state.thread_index());
     ut::Lock_free_list<TimestampNode> list;
     populate_list(list, state.range(0));
     
+    bench::Perf_scope perf(state, "standard", "prefetch");
     if (state.thread_index() == 0) {
         // Standard iteration
         for (auto _ : state) {
@@ -324,16 +347,204 @@ BENCHMARK(BM_CacheFriendlyIteration)
     ->UseRealTime()
     ->Threads(2);
 
-BENCHMARK_MAIN();
+// Nodes linked in random memory order so the hardware prefetcher can't help
+template<typename T>
+std::vector<std::unique_ptr<T>> populate_shuffled(ut::Lock_free_list<T>& list, size_t size) {
+    std::vector<std::unique_ptr<T>> nodes;
+    nodes.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        nodes.push_back(std::make_unique<T>(static_cast<int>(i)));
+    }
+    std::mt19937 gen(42);
+    std::shuffle(nodes.begin(), nodes.end(), gen);
+    for (auto& node : nodes) {
+        list.push_back(node.get());
+    }
+    return nodes;
+}
+
+// Ring prefetch distance against list size, distance 0 is the plain iterator
+template<size_t Distance>
+static void BM_PrefetchDistance(benchmark::State& state) {
+    ut::Lock_free_list<TimestampNode> list;
+    auto nodes = populate_shuffled(list, state.range(0));
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        int sum = 0;
+        if constexpr (Distance == 0) {
+            for (const auto& node : list) {
+                benchmark::DoNotOptimize(sum += node.m_value);
+            }
+        } else {
+            for (const auto& node : list.template prefetched<Distance>()) {
+                benchmark::DoNotOptimize(sum += node.m_value);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    list.clear();
+}
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 0)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 1)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 2)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 4)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 8)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 16)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_PrefetchDistance, 32)->RangeMultiplier(8)->Range(1<<10, 1<<21)->UseRealTime();
+
+// Snapshot scans against plain scans while a writer inserts and removes
+template<bool Snapshot>
+static void BM_SnapshotScan(benchmark::State& state) {
+    ut::Lock_free_list<VersionedDataNode> list;
+    std::vector<std::unique_ptr<VersionedDataNode>> stable;
+    for (int i = 0; i < state.range(0); ++i) {
+        stable.push_back(std::make_unique<VersionedDataNode>(i));
+        list.push_back(stable.back().get());
+    }
+
+    // Writer reuses a node only once it is off the list
+    std::vector<std::unique_ptr<VersionedDataNode>> pool;
+    for (int i = 0; i < 1024; ++i) {
+        pool.push_back(std::make_unique<VersionedDataNode>(-1));
+    }
+
+    std::atomic<bool> stop_flag{false};
+    std::thread writer([&]() {
+        std::mt19937 gen(1);
+        size_t next = 0;
+        while (!stop_flag.load(std::memory_order_relaxed)) {
+            auto node = pool[next % pool.size()].get();
+            if (next >= pool.size() && !node->is_unlinked()) {
+                std::this_thread::yield();
+                continue;
+            }
+            list.insert_after(stable[gen() % stable.size()].get(), node);
+            list.remove(node);
+            ++next;
+        }
+    });
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        int sum = 0;
+        if constexpr (Snapshot) {
+            for (const auto& node : list.take_snapshot()) {
+                benchmark::DoNotOptimize(sum += node.m_value);
+            }
+        } else {
+            for (const auto& node : list) {
+                benchmark::DoNotOptimize(sum += node.m_value);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+
+    stop_flag.store(true);
+    writer.join();
+    list.clear();
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_SnapshotScan, false)->Range(1<<10, 1<<16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SnapshotScan, true)->Range(1<<10, 1<<16)->UseRealTime();
+
+// Sum and filtered count over m_value, node by node against gathered chunks
+template<bool Gather>
+static void BM_GatherReduce(benchmark::State& state) {
+    ut::Lock_free_list<TimestampNode> list;
+    auto nodes = populate_shuffled(list, state.range(0));
+    std::vector<int> buffer(state.range(1));
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        int64_t sum = 0;
+        int64_t evens = 0;
+        if constexpr (Gather) {
+            ut::for_each_chunk(list, std::span<int>(buffer), [](const TimestampNode& node) { return node.m_value; },
+                [&](std::span<const int> chunk) {
+                    sum = std::accumulate(chunk.begin(), chunk.end(), sum);
+                    evens += std::count_if(chunk.begin(), chunk.end(), [](int v) { return v % 2 == 0; });
+                });
+        } else {
+            for (const auto& node : list) {
+                sum += node.m_value;
+                evens += node.m_value % 2 == 0;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+        benchmark::DoNotOptimize(evens);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    list.clear();
+}
+BENCHMARK_TEMPLATE(BM_GatherReduce, false)->ArgsProduct({{1<<10, 1<<14, 1<<18, 1<<21}, {256}})->UseRealTime();
+BENCHMARK_TEMPLATE(BM_GatherReduce, true)->ArgsProduct({{1<<10, 1<<14, 1<<18, 1<<21}, {64, 256, 4096}})->UseRealTime();
+
+// Analytics pass split over worker threads, compare threads:1 with the rest
+static void BM_ParallelForEach(benchmark::State& state) {
+    ut::Lock_free_list<TimestampNode> list;
+    populate_list(list, state.range(0));
+    const size_t num_threads = state.range(1);
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        std::atomic<int64_t> sum{0};
+        ut::parallel_for_each(list, [&sum](const TimestampNode& node) {
+            if (node.age_seconds() >= 0.0) {
+                sum.fetch_add(node.m_value, std::memory_order_relaxed);
+            }
+        }, num_threads);
+        benchmark::DoNotOptimize(sum.load());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    free_list(list);
+}
+BENCHMARK(BM_ParallelForEach)
+    ->ArgsProduct({{1<<16, 1<<20}, {1, 2, 4, 8, 16}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// Serial node_utils::average_age_seconds against the parallel reduction
+static void BM_AverageAge(benchmark::State& state) {
+    ut::Lock_free_list<TimestampNode> list;
+    populate_list(list, state.range(0));
+    const size_t num_threads = state.range(1);
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        if (num_threads == 0) {
+            benchmark::DoNotOptimize(node_utils::average_age_seconds(list.begin(), list.end()));
+        } else {
+            benchmark::DoNotOptimize(node_utils::parallel_average_age_seconds(list, num_threads));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    free_list(list);
+}
+BENCHMARK(BM_AverageAge)
+    ->ArgsProduct({{1<<16, 1<<20}, {0, 1, 2, 4, 8, 16}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+LOCKFREELIST_BENCH_MAIN();
 
 static void BM_BatchOperations(benchmark::State& state) {
     ut::Lock_free_list<TimestampNode> list;
     const size_t batch_size = state.range(1);
 
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         populate_list(list, state.range(0));
         std::vector<TimestampNode*> nodes_to_process;
+        perf.resume();
         state.ResumeTiming();
 
         // Collect batch of nodes using iterator
@@ -351,7 +562,9 @@ static void BM_BatchOperations(benchmark::State& state) {
         }
 
         state.PauseTiming();
+        perf.pause();
         free_list(list);
+        perf.resume();
         state.ResumeTiming();
     }
 
@@ -366,9 +579,12 @@ static void BM_SlidingWindow(benchmark::State& state) {
     ut::Lock_free_list<TimestampNode> list;
     const size_t window_size = state.range(1);
 
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         populate_list(list, state.range(0));
+        perf.resume();
         state.ResumeTiming();
 
         auto window_begin = list.begin();
@@ -393,7 +609,9 @@ static void BM_SlidingWindow(benchmark::State& state) {
         }
 
         state.PauseTiming();
+        perf.pause();
         free_list(list);
+        perf.resume();
         state.ResumeTiming();
     }
 }
@@ -406,15 +624,18 @@ static void BM_IteratorStability(benchmark::State& state) {
     ut::Lock_free_list<TimestampNode> list;
     std::atomic<bool> stop_flag{false};
 
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         populate_list(list, state.range(0));
         stop_flag.store(false);
 
         // Start multiple modifier threads
         std::vector<std::thread> modifier_threads;
         for (int i = 0; i < state.range(1); ++i) {
-            modifier_threads.emplace_back([&]() {
+            modifier_threads.emplace_back([&, i]() {
+                bench::Pin_scope pin(i);
                 std::random_device rd;
                 std::mt19937 gen(rd());
                 std::uniform_int_distribution<> dis(0, 2);
@@ -440,6 +661,7 @@ static void BM_IteratorStability(benchmark::State& state) {
             });
         }
 
+        perf.resume();
         state.ResumeTiming();
 
         // Measure iterator stability
@@ -458,11 +680,13 @@ static void BM_IteratorStability(benchmark::State& state) {
         }
 
         state.PauseTiming();
+        perf.pause();
         stop_flag.store(true);
         for (auto& thread : modifier_threads) {
             thread.join();
         }
         free_list(list);
+        perf.resume();
         state.ResumeTiming();
 
         benchmark::DoNotOptimize(successful_iterations);
@@ -474,11 +698,15 @@ BENCHMARK(BM_IteratorStability)
 
 // Iterator with predicate filtering
 static void BM_IteratorFiltering(benchmark::State& state) {
+    bench::Pin_scope pin(state.thread_index());
     ut::Lock_free_list<TimestampNode> list;
 
+    bench::Perf_scope perf(state, "if", "find_if");
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         populate_list(list, state.range(0));
+        perf.resume();
         state.ResumeTiming();
 
         if (state.thread_index() == 0) {
@@ -504,7 +732,9 @@ static void BM_IteratorFiltering(benchmark::State& state) {
         }
 
         state.PauseTiming();
+        perf.pause();
         list.clear();
+        perf.resume();
         state.ResumeTiming();
     }
 }
@@ -515,13 +745,17 @@ BENCHMARK(BM_IteratorFiltering)
 
 // Iterator with distance calculation
 static void BM_IteratorDistance(benchmark::State& state) {
+    bench::Pin_scope pin(state.thread_index());
     ut::Lock_free_list<TimestampNode> list;
 
+    bench::Perf_scope perf(state, "loop", "std_distance");
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         populate_list(list, state.range(0));
         auto mid_point = list.begin();
         std::advance(mid_point, state.range(0) / 2);
+        perf.resume();
         state.ResumeTiming();
 
         if (state.thread_index() == 0) {
@@ -540,7 +774,9 @@ static void BM_IteratorDistance(benchmark::State& state) {
         }
 
         state.PauseTiming();
+        perf.pause();
         free_list(list);
+        perf.resume();
         state.ResumeTiming();
     }
 }
@@ -571,11 +807,15 @@ BENCHMARK(BM_IteratorDistance)
 
 // Benchmark for iterator reuse vs creation
 static void BM_IteratorReuse(benchmark::State& state) {
+    bench::Pin_scope pin(state.thread_index());
     ut::Lock_free_list<TimestampNode> list;
 
+    bench::Perf_scope perf(state, "new", "reuse");
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         populate_list(list, state.range(0));
+        perf.resume();
         state.ResumeTiming();
 
         if (state.thread_index() == 0) {
@@ -598,7 +838,9 @@ static void BM_IteratorReuse(benchmark::State& state) {
         }
 
         state.PauseTiming();
+        perf.pause();
         free_list(list);
+        perf.resume();
         state.ResumeTiming();
     }
 }
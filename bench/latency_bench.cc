@@ -0,0 +1,240 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_stats.h"
+#include "tests/timestamp_node.h"
+#include "cpu_topology.h"
+#include "bench_main.h"
+
+// Open-loop latency harness. Worker threads are started and pinned once
+// per benchmark run and each iteration hands them a batch of operations, so
+// thread creation is not measured. Operations are issued on a Poisson
+// schedule at a fixed total rate and latency is measured from the time an
+// operation was due, not from when the worker got to it, so a stall shows
+// up in every operation queued behind it instead of being hidden by the
+// worker issuing fewer operations (coordinated omission).
+
+using clock_type = std::chrono::steady_clock;
+
+// Percent of operations of each kind, the rest are find_if
+struct Op_mix {
+    const char* m_name;
+    int m_push_back;
+    int m_pop_front;
+};
+
+static constexpr std::array<Op_mix, 3> mixes{{
+    {"read_mostly", 5, 5},
+    {"balanced", 25, 25},
+    {"queue", 50, 50},
+}};
+
+static constexpr std::array<ut::List_op, 3> measured_ops{
+    ut::List_op::push_back, ut::List_op::pop_front, ut::List_op::find_if};
+
+static const char* op_name(ut::List_op op) {
+    switch (op) {
+        case ut::List_op::push_back: return "push_back";
+        case ut::List_op::pop_front: return "pop_front";
+        default: return "find_if";
+    }
+}
+
+// Persistent pinned workers sharing one list. run() issues ops_per_worker
+// operations on every worker and returns when all are done.
+class Worker_pool {
+public:
+    Worker_pool(int num_threads, int ops_per_worker, double ops_per_sec, const Op_mix& mix, int preload)
+        : m_ops_per_worker(ops_per_worker), m_mix(mix), m_key_range(2 * preload),
+          m_workers(num_threads) {
+
+        // Mean gap between two operations of one worker, 0 is closed loop
+        m_mean_gap_ns = ops_per_sec > 0 ? 1e9 * num_threads / ops_per_sec : 0;
+
+        std::mt19937 rng(42);
+        for (int i = 0; i < preload; ++i) {
+            m_nodes.push_back(std::make_unique<DataNode>(rng() % m_key_range));
+            m_list.push_back(m_nodes.back().get());
+        }
+        for (auto& worker : m_workers) {
+            refill(worker);
+        }
+
+        for (int t = 0; t < num_threads; ++t) {
+            m_threads.emplace_back([this, t]() {
+                // Always pinned, compact unless --pin says otherwise
+                bench::Pin_scope pin(t, bench::Pinning::compact);
+                work(m_workers[t], t);
+            });
+        }
+    }
+
+    ~Worker_pool() {
+        m_stop.store(true, std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void run() {
+        m_done.store(0, std::memory_order_relaxed);
+        m_start.store(clock_type::now().time_since_epoch().count(), std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+
+        while (m_done.load(std::memory_order_acquire) < m_workers.size()) {
+            std::this_thread::yield();
+        }
+    }
+
+    ut::Latency_histogram histogram(ut::List_op op) const {
+        ut::Latency_histogram merged;
+
+        for (const auto& worker : m_workers) {
+            merged += worker.m_histograms[static_cast<size_t>(op)];
+        }
+        return merged;
+    }
+
+    Worker_pool(const Worker_pool&) = delete;
+    Worker_pool& operator=(const Worker_pool&) = delete;
+
+private:
+    struct alignas(64) Worker {
+        std::array<ut::Latency_histogram, ut::List_stats::n_ops> m_histograms{};
+
+        // Nodes this worker can push, pop_front() returns nodes here
+        std::vector<DataNode*> m_free;
+        std::vector<std::unique_ptr<DataNode>> m_owned;
+    };
+
+    // Enough free nodes that a batch of pushes never runs out
+    void refill(Worker& worker) {
+        while (worker.m_free.size() < size_t(m_ops_per_worker)) {
+            worker.m_owned.push_back(std::make_unique<DataNode>(0));
+            worker.m_free.push_back(worker.m_owned.back().get());
+        }
+    }
+
+    void work(Worker& worker, int t) {
+        std::mt19937_64 rng(t + 1);
+        std::exponential_distribution<double> gap(m_mean_gap_ns > 0 ? 1.0 / m_mean_gap_ns : 1.0);
+        std::uniform_int_distribution<int> percent(0, 99);
+        std::uniform_int_distribution<int> key(0, m_key_range - 1);
+        uint64_t seen = 0;
+
+        for (;;) {
+            while (m_generation.load(std::memory_order_acquire) == seen) {
+                std::this_thread::yield();
+            }
+            seen = m_generation.load(std::memory_order_acquire);
+
+            if (m_stop.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            auto due = clock_type::time_point(clock_type::duration(m_start.load(std::memory_order_relaxed)));
+
+            for (int i = 0; i < m_ops_per_worker; ++i) {
+                auto now = clock_type::now();
+
+                if (m_mean_gap_ns > 0) {
+                    due += std::chrono::nanoseconds(static_cast<int64_t>(gap(rng)));
+                    while (now < due) {
+                        std::this_thread::yield();
+                        now = clock_type::now();
+                    }
+                } else {
+                    due = now;
+                }
+
+                const int p = percent(rng);
+                ut::List_op op;
+
+                if (p < m_mix.m_push_back) {
+                    op = ut::List_op::push_back;
+                    auto node = worker.m_free.back();
+                    worker.m_free.pop_back();
+                    node->m_value = key(rng);
+                    m_list.push_back(node);
+                } else if (p < m_mix.m_push_back + m_mix.m_pop_front) {
+                    op = ut::List_op::pop_front;
+                    if (auto node = m_list.pop_front(); node != nullptr) {
+                        worker.m_free.push_back(static_cast<DataNode*>(node));
+                    }
+                } else {
+                    op = ut::List_op::find_if;
+                    const int k = key(rng);
+                    benchmark::DoNotOptimize(m_list.find_if([k](const DataNode* node) { return node->m_value == k; }));
+                }
+
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - due).count();
+                worker.m_histograms[static_cast<size_t>(op)].record(ns);
+            }
+
+            refill(worker);
+            m_done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    const int m_ops_per_worker;
+    const Op_mix m_mix;
+    const int m_key_range;
+    double m_mean_gap_ns;
+
+    ut::Lock_free_list<DataNode> m_list;
+    std::vector<std::unique_ptr<DataNode>> m_nodes;
+    std::vector<Worker> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<uint64_t> m_generation{0};
+    std::atomic<size_t> m_done{0};
+    std::atomic<int64_t> m_start{0};
+    std::atomic<bool> m_stop{false};
+};
+
+// state.range(0) workers issue a total of state.range(1) thousand ops/s,
+// 0 runs closed loop, in mix state.range(2) on a list of 1024 nodes.
+// Reports p50/p99/p99.9/max in ns per operation kind.
+static void BM_OpenLoop(benchmark::State& state) {
+    const int num_threads = state.range(0);
+    const double ops_per_sec = state.range(1) * 1000.0;
+    const auto& mix = mixes[state.range(2)];
+    const int ops_per_worker = 1 << 14;
+
+    Worker_pool pool(num_threads, ops_per_worker, ops_per_sec, mix, 1024);
+
+    for (auto _ : state) {
+        pool.run();
+    }
+
+    state.SetItemsProcessed(state.iterations() * num_threads * ops_per_worker);
+    state.SetLabel(mix.m_name);
+
+    for (auto op : measured_ops) {
+        const auto summary = pool.histogram(op).summary();
+
+        if (summary.m_count == 0) {
+            continue;
+        }
+
+        const std::string name = op_name(op);
+        state.counters[name + "_p50_ns"] = summary.m_p50;
+        state.counters[name + "_p99_ns"] = summary.m_p99;
+        state.counters[name + "_p999_ns"] = summary.m_p999;
+        state.counters[name + "_max_ns"] = summary.m_max;
+    }
+}
+BENCHMARK(BM_OpenLoop)
+    ->ArgNames({"threads", "kops", "mix"})
+    ->ArgsProduct({{1, 4}, {0, 100, 1000}, {0, 1, 2}})
+    ->UseRealTime();
+
+LOCKFREELIST_BENCH_MAIN();
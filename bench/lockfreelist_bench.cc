@@ -2,16 +2,29 @@
 #include <thread>
 #include <vector>
 #include <random>
+#include <algorithm>
+#include <coroutine>
+#include <atomic>
 
 #include "tests/timestamp_node.h"
+#include "unrolled_list.h"
+#include "arena_list.h"
+#include "striped_list.h"
+#include "latency_stats.h"
+#include "perf_counters.h"
+#include "cpu_topology.h"
+#include "bench_main.h"
 
 // Single-threaded push_front benchmark
 static void BM_PushFront(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         nodes.reserve(state.range(0));
+        perf.resume();
         state.ResumeTiming();
         
         for (int i = 0; i < state.range(0); ++i) {
@@ -24,43 +37,85 @@ BENCHMARK(BM_PushFront)->Range(8, 8<<10);
 
 // Multi-threaded push_front benchmark
 static void BM_PushFront_MultiThreaded(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         nodes.reserve(state.range(0));
         const int num_threads = state.range(1);
         const int items_per_thread = state.range(0) / num_threads;
-        state.ResumeTiming();
-        
-        std::vector<std::thread> threads;
+        bench::Pinned_threads threads;
         for (int t = 0; t < num_threads; ++t) {
-            threads.emplace_back([&list, &nodes, t, items_per_thread]() {
+            threads.add(t, [&list, &nodes, t, items_per_thread]() {
                 for (int i = 0; i < items_per_thread; ++i) {
                     auto node = new DataNode(t * items_per_thread + i);
                     list.push_front(node);
                 }
             });
         }
-        
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
     }
 }
 BENCHMARK(BM_PushFront_MultiThreaded)
     ->Ranges({{8, 8<<10}, {1, 8}});
 
+// Same as BM_PushFront_MultiThreaded with the pushes spread over stripes,
+// the pushed nodes are freed after the clock stops
+static void BM_StripedPushFront_MultiThreaded(benchmark::State& state) {
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        ut::Striped_lock_free_list<StripedDataNode> list;
+        const int num_threads = state.range(1);
+        const int items_per_thread = state.range(0) / num_threads;
+
+        bench::Pinned_threads threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.add(t, [&list, t, items_per_thread]() {
+                for (int i = 0; i < items_per_thread; ++i) {
+                    auto node = new StripedDataNode(t * items_per_thread + i);
+                    list.push(node);
+                }
+            });
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
+
+        state.PauseTiming();
+        perf.pause();
+        while (auto node = list.pop()) {
+            delete static_cast<StripedDataNode*>(node);
+        }
+        perf.resume();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_StripedPushFront_MultiThreaded)
+    ->Ranges({{8, 8<<10}, {1, 8}});
+
 // Mixed operations benchmark
 static void BM_MixedOperations(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         nodes.reserve(state.range(0));
         std::random_device rd;
         std::mt19937 gen(rd());
         std::uniform_int_distribution<> dis(0, 1);
+        perf.resume();
         state.ResumeTiming();
         
         for (int i = 0; i < state.range(0); ++i) {
@@ -81,16 +136,16 @@ BENCHMARK(BM_MixedOperations)->Range(8, 8<<10);
 
 // High-contention benchmark
 static void BM_HighContention(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         const int num_threads = state.range(0);
         const int operations_per_thread = 1000;
-        state.ResumeTiming();
-        
-        std::vector<std::thread> threads;
+        bench::Pinned_threads threads;
         for (int t = 0; t < num_threads; ++t) {
-            threads.emplace_back([&list, operations_per_thread]() {
+            threads.add(t, [&list, t, operations_per_thread]() {
                 std::random_device rd;
                 std::mt19937 gen(rd());
                 std::uniform_int_distribution<> dis(0, 1);
@@ -108,20 +163,24 @@ static void BM_HighContention(benchmark::State& state) {
                 }
             });
         }
-        
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
     }
 }
 BENCHMARK(BM_HighContention)->Range(1, 32);
 
 static void BM_PushBack(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         nodes.reserve(state.range(0));
+        perf.resume();
         state.ResumeTiming();
         
         for (int i = 0; i < state.range(0); ++i) {
@@ -134,37 +193,131 @@ BENCHMARK(BM_PushBack)->Range(8, 8<<10);
 
 // Multi-threaded push_back benchmark
 static void BM_PushBack_MultiThreaded(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         nodes.reserve(state.range(0));
         const int num_threads = state.range(1);
         const int items_per_thread = state.range(0) / num_threads;
-        state.ResumeTiming();
-        
-        std::vector<std::thread> threads;
+        bench::Pinned_threads threads;
         for (int t = 0; t < num_threads; ++t) {
-            threads.emplace_back([&list, &nodes, t, items_per_thread]() {
+            threads.add(t, [&list, &nodes, t, items_per_thread]() {
                 for (int i = 0; i < items_per_thread; ++i) {
                     auto node = new DataNode(t * items_per_thread + i);
                     list.push_back(node);
                 }
             });
         }
-        
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
     }
 }
 BENCHMARK(BM_PushBack_MultiThreaded)
     ->Ranges({{8, 8<<10}, {1, 8}});
 
+// push_back from state.range(0) threads on a list with Contention_stats,
+// reports retries, CAS failures and tail lags per push
+static void BM_PushBackContention(benchmark::State& state) {
+    using List = ut::Lock_free_list<DataNode, ut::Concurrency::MPMC, ut::Contention_stats<>>;
+    const int num_threads = state.range(0);
+    const int items_per_thread = 4096;
+
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < num_threads * items_per_thread; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    ut::List_stats totals;
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        List list;
+        bench::Pinned_threads threads;
+
+        for (int t = 0; t < num_threads; ++t) {
+            threads.add(t, [&, t]() {
+                for (int i = 0; i < items_per_thread; ++i) {
+                    list.push_back(nodes[t * items_per_thread + i].get());
+                }
+            });
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
+
+        auto stats = list.stats();
+        totals.m_calls[size_t(ut::List_op::push_back)] += stats.calls(ut::List_op::push_back);
+        totals.m_attempts[size_t(ut::List_op::push_back)] += stats.attempts(ut::List_op::push_back);
+        totals.m_cas_failures[size_t(ut::List_op::push_back)] += stats.cas_failures(ut::List_op::push_back);
+        totals.m_tail_lags += stats.m_tail_lags;
+    }
+
+    const double calls = totals.calls(ut::List_op::push_back);
+    state.SetItemsProcessed(state.iterations() * num_threads * items_per_thread);
+    state.counters["retries/op"] = (totals.attempts(ut::List_op::push_back) - calls) / calls;
+    state.counters["cas_failures/op"] = totals.cas_failures(ut::List_op::push_back) / calls;
+    state.counters["tail_lags/op"] = totals.m_tail_lags / calls;
+}
+BENCHMARK(BM_PushBackContention)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+// push_back from state.range(0) threads on a list with Latency_stats,
+// reports the per-call tail that the mean time hides
+static void BM_PushBackLatency(benchmark::State& state) {
+    using List = ut::Lock_free_list<DataNode, ut::Concurrency::MPMC, ut::Latency_stats<>>;
+    const int num_threads = state.range(0);
+    const int items_per_thread = 4096;
+
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < num_threads * items_per_thread; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    List list;
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        bench::Pinned_threads threads;
+
+        for (int t = 0; t < num_threads; ++t) {
+            threads.add(t, [&, t]() {
+                for (int i = 0; i < items_per_thread; ++i) {
+                    list.push_back(nodes[t * items_per_thread + i].get());
+                }
+            });
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
+        list.clear();
+    }
+
+    const auto summary = ut::latencies(list, ut::List_op::push_back).summary();
+    state.SetItemsProcessed(state.iterations() * num_threads * items_per_thread);
+    state.counters["p50_ns"] = summary.m_p50;
+    state.counters["p99_ns"] = summary.m_p99;
+    state.counters["p99.9_ns"] = summary.m_p999;
+    state.counters["max_ns"] = summary.m_max;
+}
+BENCHMARK(BM_PushBackLatency)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
 // Find operation benchmark
 static void BM_Find(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         const int size = state.range(0);
@@ -176,6 +329,7 @@ static void BM_Find(benchmark::State& state) {
             list.push_back(nodes.back().get());
         }
         
+        perf.resume();
         state.ResumeTiming();
         
         // Search for random values
@@ -190,8 +344,10 @@ BENCHMARK(BM_Find)->Range(8, 8<<10);
 
 // Insert after benchmark
 static void BM_InsertAfter(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         std::vector<std::unique_ptr<DataNode>> nodes;
         nodes.reserve(state.range(0) + 1);
@@ -201,6 +357,7 @@ static void BM_InsertAfter(benchmark::State& state) {
         list.push_back(initial);
         nodes.emplace_back(initial);
         
+        perf.resume();
         state.ResumeTiming();
         
         for (int i = 1; i <= state.range(0); ++i) {
@@ -214,16 +371,16 @@ BENCHMARK(BM_InsertAfter)->Range(8, 8<<10);
 
 // Concurrent mixed operations benchmark
 static void BM_ConcurrentMixedOps(benchmark::State& state) {
+    bench::Perf_scope perf(state);
     for (auto _ : state) {
         state.PauseTiming();
+        perf.pause();
         ut::Lock_free_list<DataNode> list;
         const int num_threads = state.range(0);
         const int operations_per_thread = 1000;
-        state.ResumeTiming();
-        
-        std::vector<std::thread> threads;
+        bench::Pinned_threads threads;
         for (int t = 0; t < num_threads; ++t) {
-            threads.emplace_back([&list, operations_per_thread]() {
+            threads.add(t, [&list, t, operations_per_thread]() {
                 std::random_device rd;
                 std::mt19937 gen(rd());
                 std::uniform_int_distribution<> dis(0, 2);
@@ -246,13 +403,317 @@ static void BM_ConcurrentMixedOps(benchmark::State& state) {
                 }
             });
         }
-        
-        for (auto& thread : threads) {
-            thread.join();
-        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
     }
 }
 BENCHMARK(BM_ConcurrentMixedOps)->Range(1, 32);
 
-BENCHMARK_MAIN();
+// Many readers recording accesses on one hot node
+template<typename NodeType>
+static void BM_HotNodeAccess(benchmark::State& state) {
+    static NodeType node(0);
+
+    bench::Pin_scope pin(state.thread_index());
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        for (int i = 0; i < 64; ++i) {
+            node.record_access();
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        state.counters["estimate"] = static_cast<double>(node.get_access_count());
+        node.reset_access_count();
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK_TEMPLATE(BM_HotNodeAccess, TimestampNode)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HotNodeAccess, ShardedTimestampNode)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HotNodeAccess, MorrisTimestampNode)->ThreadRange(1, 32)->UseRealTime();
+
+// Push into an unrolled list, compare with BM_PushBack
+static void BM_UnrolledPush(benchmark::State& state) {
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        ut::Unrolled_list<int> list;
+        for (int i = 0; i < state.range(0); ++i) {
+            list.push(i);
+        }
+        benchmark::DoNotOptimize(list.m_head.load());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UnrolledPush)->Range(8, 8<<10);
+
+// Concurrent push and pop, slot CAS against head CAS
+static void BM_UnrolledPushPop_MultiThreaded(benchmark::State& state) {
+    static ut::Unrolled_list<int> list;
+
+    bench::Pin_scope pin(state.thread_index());
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        for (int i = 0; i < 64; ++i) {
+            list.push(i);
+        }
+        int value;
+        for (int i = 0; i < 64; ++i) {
+            benchmark::DoNotOptimize(list.try_pop(value));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 128);
+}
+BENCHMARK(BM_UnrolledPushPop_MultiThreaded)->ThreadRange(1, 16)->UseRealTime();
+
+// Sum over small payloads, one node per value against K values per chunk
+template<bool Unrolled>
+static void BM_SmallPayloadIteration(benchmark::State& state) {
+    ut::Unrolled_list<int> unrolled;
+    ut::Lock_free_list<DataNode> list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+
+    for (int i = 0; i < state.range(0); ++i) {
+        if constexpr (Unrolled) {
+            unrolled.push(i);
+        } else {
+            nodes.push_back(std::make_unique<DataNode>(i));
+            list.push_back(nodes.back().get());
+        }
+    }
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        int64_t sum = 0;
+        if constexpr (Unrolled) {
+            for (auto value : unrolled) {
+                sum += value;
+            }
+        } else {
+            for (const auto& node : list) {
+                sum += node.m_value;
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_SmallPayloadIteration, false)->Range(1<<10, 1<<20);
+BENCHMARK_TEMPLATE(BM_SmallPayloadIteration, true)->Range(1<<10, 1<<20);
+
+// find_if over 32-bit index links against 64-bit tagged pointers
+template<bool Arena>
+static void BM_FindIfLinkWidth(benchmark::State& state) {
+    const auto n = int(state.range(0));
+    ut::Arena_list<int> arena(n);
+    ut::Lock_free_list<DataNode> list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+
+    for (int i = 0; i < n; ++i) {
+        if constexpr (Arena) {
+            arena.push_front(i);
+        } else {
+            nodes.push_back(std::make_unique<DataNode>(i));
+            list.push_front(nodes.back().get());
+        }
+    }
+
+    // The value pushed first is at the back, so every search walks the list
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        if constexpr (Arena) {
+            benchmark::DoNotOptimize(arena.find_if([](int v) { return v == 0; }));
+        } else {
+            auto it = std::find_if(list.begin(), list.end(), [](const DataNode& node) { return node.m_value == 0; });
+            benchmark::DoNotOptimize(it);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK_TEMPLATE(BM_FindIfLinkWidth, false)->Range(1<<10, 1<<20);
+BENCHMARK_TEMPLATE(BM_FindIfLinkWidth, true)->Range(1<<10, 1<<20);
+
+// push_back/pop_front throughput per concurrency mode, with as many
+// producers and consumers as the mode allows (3 for the "many" sides)
+template<ut::Concurrency Mode>
+static void BM_QueueMode(benchmark::State& state) {
+    using List = ut::Lock_free_list<DataNode, Mode>;
+    const int num_producers = Mode == ut::Concurrency::SPSC || Mode == ut::Concurrency::SPMC ? 1 : 3;
+    const int num_consumers = List::single_consumer ? 1 : 3;
+    const int items_per_producer = state.range(0);
+    const int total = num_producers * items_per_producer;
+
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < total; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        List list;
+        std::atomic<int> popped{0};
+        bench::Pinned_threads threads;
+
+        for (int t = 0; t < num_producers; ++t) {
+            threads.add(t, [&, t]() {
+                for (int i = 0; i < items_per_producer; ++i) {
+                    list.push_back(nodes[t * items_per_producer + i].get());
+                }
+            });
+        }
+        for (int t = 0; t < num_consumers; ++t) {
+            threads.add(num_producers + t, [&]() {
+                while (popped.load(std::memory_order_relaxed) < total) {
+                    if (list.pop_front() != nullptr) {
+                        popped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+    state.counters["producers"] = num_producers;
+    state.counters["consumers"] = num_consumers;
+}
+BENCHMARK_TEMPLATE(BM_QueueMode, ut::Concurrency::SPSC)->Range(1<<10, 1<<16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_QueueMode, ut::Concurrency::MPSC)->Range(1<<10, 1<<16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_QueueMode, ut::Concurrency::SPMC)->Range(1<<10, 1<<16)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_QueueMode, ut::Concurrency::MPMC)->Range(1<<10, 1<<16)->UseRealTime();
+
+// Many producers and one consumer, the consumer drains in batches of
+// state.range(1) nodes, 1 is the same as pop_front()
+static void BM_MpscDrain(benchmark::State& state) {
+    const int num_producers = 4;
+    const int items_per_producer = state.range(0);
+    const size_t batch = state.range(1);
+    const int total = num_producers * items_per_producer;
+
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < total; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        ut::Mpsc_list<DataNode> list;
+        bench::Pinned_threads producers;
+
+        for (int t = 0; t < num_producers; ++t) {
+            producers.add(t, [&, t]() {
+                for (int i = 0; i < items_per_producer; ++i) {
+                    list.push_back(nodes[t * items_per_producer + i].get());
+                }
+            });
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        producers.start();
+        int64_t sum{};
+        for (int drained = 0; drained < total; ) {
+            drained += list.drain([&sum](DataNode& node) { sum += node.m_value; }, batch);
+        }
+        benchmark::DoNotOptimize(sum);
+        producers.join();
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_MpscDrain)->ArgsProduct({{1<<12, 1<<16}, {1, 64}})->UseRealTime();
+
+// Fire and forget coroutine for the consumer benchmarks
+struct Detached_task {
+    struct promise_type {
+        Detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Two producers feed state.range(1) consumers. Thread consumers block in
+// pop_front_wait(), coroutine consumers co_await next() and are queued on
+// the list by the producer that woke them, one consumer thread resumes
+// them all.
+template<bool Coroutines>
+static void BM_Consumers(benchmark::State& state) {
+    const int num_producers = 2;
+    const int num_consumers = state.range(1);
+    const int total = state.range(0) / num_consumers * num_consumers;
+
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < total; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    bench::Perf_scope perf(state);
+    for (auto _ : state) {
+        state.PauseTiming();
+        perf.pause();
+        ut::Blocking_list<DataNode> list;
+        std::atomic<int> consumed{0};
+        bench::Pinned_threads threads;
+
+        if constexpr (Coroutines) {
+            auto consumer = [](ut::Blocking_list<DataNode>& list, int n, std::atomic<int>& consumed) -> Detached_task {
+                for (int i = 0; i < n; ++i) {
+                    benchmark::DoNotOptimize(co_await list.next());
+                }
+                consumed.fetch_add(n, std::memory_order_release);
+            };
+            for (int t = 0; t < num_consumers; ++t) {
+                consumer(list, total / num_consumers, consumed);
+            }
+            threads.add(num_producers, [&]() {
+                while (consumed.load(std::memory_order_acquire) < total) {
+                    if (list.resume_woken() == 0) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        } else {
+            for (int t = 0; t < num_consumers; ++t) {
+                threads.add(num_producers + t, [&]() {
+                    while (consumed.load(std::memory_order_relaxed) < total) {
+                        if (list.pop_front_wait(std::chrono::milliseconds(1)) != nullptr) {
+                            consumed.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                });
+            }
+        }
+
+        for (int t = 0; t < num_producers; ++t) {
+            threads.add(t, [&, t]() {
+                for (int i = t; i < total; i += num_producers) {
+                    list.push_back(nodes[i].get());
+                }
+            });
+        }
+        perf.resume();
+        state.ResumeTiming();
+
+        threads.start();
+        threads.join();
+        while (consumed.load(std::memory_order_acquire) < total) {
+            std::this_thread::yield();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+BENCHMARK_TEMPLATE(BM_Consumers, false)->ArgsProduct({{1<<14}, {1, 4, 16}})->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Consumers, true)->ArgsProduct({{1<<14}, {1, 4, 16}})->UseRealTime();
+
+LOCKFREELIST_BENCH_MAIN();
 
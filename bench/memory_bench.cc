@@ -0,0 +1,353 @@
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "tests/timestamp_node.h"
+#include "arena_list.h"
+#include "unrolled_list.h"
+#include "bench_main.h"
+
+// Memory footprint of N elements and what is left of the heap after churn,
+// for Lock_free_list with DataNode and TimestampNode under three ways of
+// managing nodes, and for the compact-link Arena_list and the chunked
+// Unrolled_list holding the same int payload. Every run:
+//
+//  1. builds a list of state.range(0) elements and reports heap and RSS
+//     bytes per element, and the bytes beyond the node type itself
+//  2. churns it: removes a random half, inserts as many new elements with an
+//     unrelated allocation between every two of them, four times over
+//  3. frees the unrelated allocations and reports the heap still held per
+//     element and the fraction of it that is free but not returned
+//
+// Heap numbers come from glibc's mallinfo2(), elsewhere only RSS is
+// reported. Runs are single threaded so removed nodes can be freed at once.
+// Lists insert with push_front().
+
+// How a Lock_free_list gets and gives back its nodes
+enum class Reclaim {
+    immediate,  // new per node, delete as soon as it is removed
+    deferred,   // new per node, deleted in batches like epoch reclamation
+    pool,       // one block holding every node, removed nodes are reused
+};
+
+struct Memory_usage {
+    size_t m_heap_in_use;
+    size_t m_heap_total;
+    size_t m_rss;
+};
+
+static Memory_usage memory_usage() {
+    Memory_usage usage{};
+
+    size_t pages = 0;
+    size_t resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (statm >> pages >> resident) {
+        usage.m_rss = resident * sysconf(_SC_PAGESIZE);
+    }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const auto info = mallinfo2();
+    usage.m_heap_in_use = info.uordblks + info.hblkhd;
+    usage.m_heap_total = info.arena + info.hblkhd;
+#endif
+    return usage;
+}
+
+static constexpr bool have_heap_stats =
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    true;
+#else
+    false;
+#endif
+
+static constexpr int churn_rounds = 4;
+static constexpr size_t deferred_batch = 4096;
+
+// Allocations of other code interleaved with the list's, 16 to 256 bytes
+class Noise {
+public:
+    void allocate(std::mt19937& rng) {
+        m_blocks.push_back(std::make_unique<char[]>(std::uniform_int_distribution<size_t>(16, 256)(rng)));
+    }
+
+    void clear() {
+        m_blocks.clear();
+        m_blocks.shrink_to_fit();
+    }
+
+private:
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+};
+
+// Nodes for one list under a Reclaim mode. Free and retired nodes are
+// chained through m_next, which the list no longer uses, so the source
+// allocates nothing but the nodes and its bookkeeping is not counted as
+// node overhead.
+template<typename NodeType, Reclaim R>
+class Node_source {
+public:
+    explicit Node_source(size_t capacity) {
+        if constexpr (R == Reclaim::pool) {
+            m_pool = static_cast<NodeType*>(::operator new(capacity * sizeof(NodeType), std::align_val_t(alignof(NodeType))));
+            for (size_t i = capacity; i > 0; --i) {
+                push(m_free, new (m_pool + i - 1) NodeType(0));
+            }
+            m_capacity = capacity;
+        }
+    }
+
+    ~Node_source() {
+        release();
+
+        if constexpr (R == Reclaim::pool) {
+            for (size_t i = 0; i < m_capacity; ++i) {
+                m_pool[i].~NodeType();
+            }
+            ::operator delete(m_pool, std::align_val_t(alignof(NodeType)));
+        }
+    }
+
+    NodeType* get(int value) {
+        if constexpr (R == Reclaim::pool) {
+            auto node = pop(m_free);
+            node->m_value = value;
+            return node;
+        } else {
+            return new NodeType(value);
+        }
+    }
+
+    void put(NodeType* node) {
+        if constexpr (R == Reclaim::immediate) {
+            delete node;
+        } else if constexpr (R == Reclaim::deferred) {
+            push(m_retired, node);
+            if (++m_n_retired >= deferred_batch) {
+                release();
+            }
+        } else {
+            push(m_free, node);
+        }
+    }
+
+    // Free the nodes still in the list
+    void put_all(std::vector<NodeType*>& nodes) {
+        for (auto node : nodes) {
+            if constexpr (R == Reclaim::pool) {
+                push(m_free, node);
+            } else {
+                delete node;
+            }
+        }
+        nodes.clear();
+    }
+
+    Node_source(const Node_source&) = delete;
+    Node_source& operator=(const Node_source&) = delete;
+
+private:
+    static void push(NodeType*& top, NodeType* node) {
+        node->m_next.store(ut::Node::Tag{top, 0}, std::memory_order_relaxed);
+        top = node;
+    }
+
+    static NodeType* pop(NodeType*& top) {
+        auto node = top;
+        top = static_cast<NodeType*>((ut::Node*)node->m_next.load(std::memory_order_relaxed));
+        return node;
+    }
+
+    void release() {
+        while (m_retired != nullptr) {
+            delete pop(m_retired);
+        }
+        m_n_retired = 0;
+    }
+
+    NodeType* m_pool{};
+    size_t m_capacity{};
+    NodeType* m_free{};
+    NodeType* m_retired{};
+    size_t m_n_retired{};
+};
+
+// Reports the counters from usage before the list, after building it and
+// after churn with the noise freed. Heap the list holds after churn is what
+// it uses plus the free chunks churn left behind, fragmentation the share
+// of those free chunks.
+static void report(benchmark::State& state, size_t n, size_t element_size,
+                   const Memory_usage& before, const Memory_usage& built, const Memory_usage& churned) {
+    const double elements = double(n);
+
+    state.counters["element_size"] = double(element_size);
+    state.counters["rss_bytes/elem"] = (double(built.m_rss) - double(before.m_rss)) / elements;
+
+    if (have_heap_stats) {
+        const auto free_bytes = [](const Memory_usage& usage) {
+            return double(usage.m_heap_total) - double(usage.m_heap_in_use);
+        };
+        const double heap = double(built.m_heap_in_use) - double(before.m_heap_in_use);
+        const double in_use = double(churned.m_heap_in_use) - double(before.m_heap_in_use);
+        const double holes = std::max(0.0, free_bytes(churned) - free_bytes(before));
+
+        state.counters["heap_bytes/elem"] = heap / elements;
+        state.counters["overhead_bytes/elem"] = heap / elements - double(element_size);
+        state.counters["retained_bytes/elem"] = (in_use + holes) / elements;
+        state.counters["fragmentation"] = in_use + holes > 0 ? holes / (in_use + holes) : 0;
+    }
+}
+
+template<typename NodeType, Reclaim R>
+static void BM_ListMemory(benchmark::State& state) {
+    const size_t n = state.range(0);
+
+    for (auto _ : state) {
+        // Handles to the nodes in the list, allocated before measuring
+        std::vector<NodeType*> live;
+        live.reserve(n);
+
+        malloc_trim(0);
+        const auto before = memory_usage();
+
+        std::mt19937 rng(42);
+        Memory_usage built;
+        Memory_usage churned;
+        {
+            Node_source<NodeType, R> source(n);
+            ut::Lock_free_list<NodeType> list;
+            Noise noise;
+
+            for (size_t i = 0; i < n; ++i) {
+                live.push_back(source.get(int(i)));
+                list.push_front(live.back());
+            }
+            built = memory_usage();
+
+            for (int round = 0; round < churn_rounds; ++round) {
+                std::shuffle(live.begin(), live.end(), rng);
+
+                for (size_t i = n / 2; i < n; ++i) {
+                    list.remove(live[i]);
+                    source.put(live[i]);
+                }
+                for (size_t i = n / 2; i < n; ++i) {
+                    noise.allocate(rng);
+                    live[i] = source.get(int(i));
+                    list.push_front(live[i]);
+                }
+            }
+
+            noise.clear();
+            churned = memory_usage();
+
+            list.clear();
+            source.put_all(live);
+        }
+
+        report(state, n, sizeof(NodeType), before, built, churned);
+    }
+}
+
+// Arena_list<int>: 32-bit index links in one preallocated arena
+static void BM_ArenaMemory(benchmark::State& state) {
+    const size_t n = state.range(0);
+
+    for (auto _ : state) {
+        std::vector<uint32_t> live;
+        live.reserve(n);
+
+        malloc_trim(0);
+        const auto before = memory_usage();
+
+        std::mt19937 rng(42);
+        Memory_usage built;
+        Memory_usage churned;
+        {
+            ut::Arena_list<int> list(static_cast<uint32_t>(n));
+            Noise noise;
+
+            for (size_t i = 0; i < n; ++i) {
+                live.push_back(list.push_front(int(i)));
+            }
+            built = memory_usage();
+
+            for (int round = 0; round < churn_rounds; ++round) {
+                std::shuffle(live.begin(), live.end(), rng);
+
+                for (size_t i = n / 2; i < n; ++i) {
+                    list.remove(live[i]);
+                }
+                for (size_t i = n / 2; i < n; ++i) {
+                    noise.allocate(rng);
+                    live[i] = list.push_front(int(i));
+                }
+            }
+
+            noise.clear();
+            churned = memory_usage();
+        }
+
+        report(state, n, sizeof(ut::Arena_list<int>::Arena_node), before, built, churned);
+    }
+}
+
+// Unrolled_list<int>: values packed in cache line chunks. Churn pops any
+// value rather than a random one, remove(value) is a linear scan, and pops
+// slow down as emptied chunks pile up, so it stops at 64K elements.
+static void BM_UnrolledMemory(benchmark::State& state) {
+    const size_t n = state.range(0);
+
+    for (auto _ : state) {
+        malloc_trim(0);
+        const auto before = memory_usage();
+
+        std::mt19937 rng(42);
+        Memory_usage built;
+        Memory_usage churned;
+        {
+            ut::Unrolled_list<int> list;
+            Noise noise;
+
+            for (size_t i = 0; i < n; ++i) {
+                list.push(int(i));
+            }
+            built = memory_usage();
+
+            for (int round = 0; round < churn_rounds; ++round) {
+                int value;
+                for (size_t i = n / 2; i < n; ++i) {
+                    list.try_pop(value);
+                }
+                for (size_t i = n / 2; i < n; ++i) {
+                    noise.allocate(rng);
+                    list.push(int(i));
+                }
+            }
+
+            noise.clear();
+            churned = memory_usage();
+        }
+
+        report(state, n, sizeof(int), before, built, churned);
+    }
+}
+
+#define MEMORY_ARGS ->RangeMultiplier(16)->Range(1<<12, 1<<20)->Iterations(1)->Unit(benchmark::kMillisecond)
+
+BENCHMARK_TEMPLATE(BM_ListMemory, DataNode, Reclaim::immediate) MEMORY_ARGS;
+BENCHMARK_TEMPLATE(BM_ListMemory, DataNode, Reclaim::deferred) MEMORY_ARGS;
+BENCHMARK_TEMPLATE(BM_ListMemory, DataNode, Reclaim::pool) MEMORY_ARGS;
+BENCHMARK_TEMPLATE(BM_ListMemory, TimestampNode, Reclaim::immediate) MEMORY_ARGS;
+BENCHMARK_TEMPLATE(BM_ListMemory, TimestampNode, Reclaim::deferred) MEMORY_ARGS;
+BENCHMARK_TEMPLATE(BM_ListMemory, TimestampNode, Reclaim::pool) MEMORY_ARGS;
+BENCHMARK(BM_ArenaMemory) MEMORY_ARGS;
+BENCHMARK(BM_UnrolledMemory)->RangeMultiplier(16)->Range(1<<12, 1<<16)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+LOCKFREELIST_BENCH_MAIN();
@@ -0,0 +1,162 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "numa_list.h"
+#include "tests/timestamp_node.h"
+#include "bench_main.h"
+
+// CPUs taking one from each node in turn, so thread t and t + 1 are on
+// different sockets whenever there is more than one
+static std::vector<int> scatter_cpus() {
+    const auto& topology = ut::numa::Topology::get();
+    std::vector<int> cpus;
+
+    for (size_t i = 0; cpus.size() < topology.m_cpu_node.size(); ++i) {
+        bool any = false;
+        for (int node = 0; node < topology.node_count(); ++node) {
+            if (i < topology.cpus_of(node).size()) {
+                cpus.push_back(topology.cpus_of(node)[i]);
+                any = true;
+            }
+        }
+        if (!any) {
+            break;
+        }
+    }
+    return cpus;
+}
+
+static void pin_to_cpu(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+// Pinned threads pushing and popping batches of nodes. Sharded keeps one
+// list per node, otherwise all threads share one list. Local allocates each
+// thread's nodes on its own node, otherwise everything comes from node 0.
+template<bool Sharded, bool Local>
+static void BM_NumaPushPop(benchmark::State& state) {
+    static const int BATCH = 64;
+    const int num_threads = state.range(0);
+    const int ops_per_thread = state.range(1);
+    const auto cpus = scatter_cpus();
+
+    ut::numa::Arena<DataNode> arena;
+
+    for (auto _ : state) {
+        ut::Lock_free_list<DataNode> single;
+        ut::Numa_sharded_list<DataNode> sharded;
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                pin_to_cpu(cpus[t % cpus.size()]);
+
+                std::vector<DataNode*> nodes;
+                for (int i = 0; i < BATCH; ++i) {
+                    nodes.push_back(Local ? arena.create_local(i) : arena.create(0, i));
+                }
+
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+
+                for (int op = 0; op < ops_per_thread; op += 2 * BATCH) {
+                    for (auto node : nodes) {
+                        if constexpr (Sharded) {
+                            sharded.push(node);
+                        } else {
+                            single.push_front(node);
+                        }
+                    }
+                    nodes.clear();
+                    while (nodes.size() < BATCH) {
+                        ut::Node* node;
+                        if constexpr (Sharded) {
+                            node = sharded.pop();
+                        } else {
+                            node = single.pop_front();
+                        }
+                        if (node != nullptr) {
+                            nodes.push_back(static_cast<DataNode*>(node));
+                        }
+                    }
+                }
+
+                for (auto node : nodes) {
+                    arena.destroy(node);
+                }
+            });
+        }
+
+        while (ready.load() < num_threads) {
+            std::this_thread::yield();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        state.SetIterationTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    state.SetItemsProcessed(state.iterations() * num_threads * ops_per_thread);
+    state.counters["nodes"] = ut::numa::Topology::get().node_count();
+}
+BENCHMARK_TEMPLATE(BM_NumaPushPop, false, false)->ArgsProduct({{1, 2, 4, 8, 16, 32}, {1<<16}})->UseManualTime();
+BENCHMARK_TEMPLATE(BM_NumaPushPop, false, true)->ArgsProduct({{1, 2, 4, 8, 16, 32}, {1<<16}})->UseManualTime();
+BENCHMARK_TEMPLATE(BM_NumaPushPop, true, false)->ArgsProduct({{1, 2, 4, 8, 16, 32}, {1<<16}})->UseManualTime();
+BENCHMARK_TEMPLATE(BM_NumaPushPop, true, true)->ArgsProduct({{1, 2, 4, 8, 16, 32}, {1<<16}})->UseManualTime();
+
+// Walk a list whose nodes are all on one node, from a thread pinned to
+// each node in turn, to see the remote access penalty on its own
+static void BM_NumaRemoteWalk(benchmark::State& state) {
+    const auto& topology = ut::numa::Topology::get();
+    const int reader_node = state.range(0) % topology.node_count();
+
+    ut::numa::Arena<DataNode> arena;
+    ut::Lock_free_list<DataNode> list;
+    std::vector<DataNode*> nodes;
+
+    for (int i = 0; i < state.range(1); ++i) {
+        nodes.push_back(arena.create(0, i));
+        list.push_back(nodes.back());
+    }
+
+    pin_to_cpu(topology.cpus_of(reader_node).front());
+
+    for (auto _ : state) {
+        int64_t sum = 0;
+        for (const auto& node : list) {
+            sum += node.m_value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.counters["reader_node"] = reader_node;
+
+    // Let the next benchmark run anywhere again
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : scatter_cpus()) {
+        CPU_SET(cpu, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+
+    list.clear();
+    for (auto node : nodes) {
+        arena.destroy(node);
+    }
+}
+BENCHMARK(BM_NumaRemoteWalk)->ArgsProduct({{0, 1}, {1<<16, 1<<20}});
+
+LOCKFREELIST_BENCH_MAIN();
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+// perf_event_attr::config of a PERF_TYPE_HW_CACHE event
+constexpr uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result) {
+    return cache | (op << 8) | (result << 16);
+}
+
+// Hardware counters of the calling thread, opened with perf_event_open.
+// With inherit they also count threads the caller starts afterwards, which
+// fold their counts in when they exit, so threads that a benchmark starts
+// and joins are counted. User space only, so it works with
+// perf_event_paranoid up to 2. Events the CPU or VM does not have are left
+// out, if none can be opened the benchmarks only report time.
+class Perf_counters {
+public:
+    struct Event {
+        const char* m_name;
+        uint32_t m_type;
+        uint64_t m_config;
+    };
+
+#if defined(__linux__)
+    static constexpr std::array<Event, 4> events{{
+        {"cycles/op", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {"cache-misses/op", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {"LLC-misses/op", PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {"branch-misses/op", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+#else
+    static constexpr std::array<Event, 0> events{};
+#endif
+
+    explicit Perf_counters(bool inherit) {
+        m_fds.fill(-1);
+
+#if defined(__linux__)
+        for (size_t i = 0; i < events.size(); ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].m_type;
+            attr.config = events[i].m_config;
+            attr.disabled = 1;
+            attr.inherit = inherit ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            m_fds[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#else
+        (void)inherit;
+#endif
+
+        if (!available()) {
+            static const bool warned = [] {
+                std::cerr << "perf_event_open failed, hardware counters are not reported" << std::endl;
+                return true;
+            }();
+            (void)warned;
+        }
+    }
+
+    ~Perf_counters() {
+#if defined(__linux__)
+        for (auto fd : m_fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    bool available() const noexcept {
+        for (auto fd : m_fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void reset_and_enable() noexcept {
+        for (auto fd : m_fds) {
+            if (fd >= 0) {
+                ioctl_fd(fd, reset_request());
+                ioctl_fd(fd, enable_request());
+            }
+        }
+    }
+
+    void enable() noexcept {
+        for (auto fd : m_fds) {
+            if (fd >= 0) {
+                ioctl_fd(fd, enable_request());
+            }
+        }
+    }
+
+    void disable() noexcept {
+        for (auto fd : m_fds) {
+            if (fd >= 0) {
+                ioctl_fd(fd, disable_request());
+            }
+        }
+    }
+
+    // Count of event i, scaled up if the kernel multiplexed it. -1 if the
+    // event is not available.
+    double read(size_t i) const noexcept {
+#if defined(__linux__)
+        uint64_t values[3]{};
+
+        if (m_fds[i] < 0 || ::read(m_fds[i], values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+            return -1;
+        }
+        return static_cast<double>(values[0]) * values[1] / values[2];
+#else
+        (void)i;
+        return -1;
+#endif
+    }
+
+    Perf_counters(const Perf_counters&) = delete;
+    Perf_counters& operator=(const Perf_counters&) = delete;
+
+private:
+#if defined(__linux__)
+    static unsigned long reset_request() noexcept { return PERF_EVENT_IOC_RESET; }
+    static unsigned long enable_request() noexcept { return PERF_EVENT_IOC_ENABLE; }
+    static unsigned long disable_request() noexcept { return PERF_EVENT_IOC_DISABLE; }
+
+    static void ioctl_fd(int fd, unsigned long request) noexcept {
+        ::ioctl(fd, request, 0);
+    }
+#else
+    static unsigned long reset_request() noexcept { return 0; }
+    static unsigned long enable_request() noexcept { return 0; }
+    static unsigned long disable_request() noexcept { return 0; }
+    static void ioctl_fd(int, unsigned long) noexcept {}
+#endif
+
+    std::array<int, events.size()> m_fds;
+};
+
+// Counts the hardware events of the calling thread from construction to
+// stop() or destruction and reports them as state.counters per operation:
+// per item if the benchmark called SetItemsProcessed(), else per
+// iteration. Construct it right before the timing loop and bracket
+// PauseTiming()/ResumeTiming() with pause()/resume(). A single threaded
+// benchmark also counts the threads it starts. With ->Threads() every
+// thread counts only itself and the counters are its per-op numbers
+// averaged over the threads.
+class Perf_scope {
+public:
+    explicit Perf_scope(benchmark::State& state)
+        : Perf_scope(state, nullptr, state.threads()) {}
+
+    // For benchmarks where thread 0 runs one variant and the other threads
+    // another: the counters are averaged per variant and prefixed with its
+    // name, e.g. "iterator:cycles/op"
+    Perf_scope(benchmark::State& state, const char* first_thread, const char* other_threads)
+        : Perf_scope(state, state.thread_index() == 0 ? first_thread : other_threads, state.thread_index() == 0 ? 1 : state.threads() - 1) {}
+
+    ~Perf_scope() {
+        stop();
+
+        if (!m_active) {
+            return;
+        }
+
+        const auto items = m_state.items_processed();
+        const double ops = static_cast<double>(items > 0 ? items : m_state.iterations());
+
+        for (size_t i = 0; i < Perf_counters::events.size(); ++i) {
+            if (auto count = m_counters.read(i); count >= 0 && ops > 0) {
+                const double per_op = count / ops;
+
+                if (m_variant == nullptr) {
+                    m_state.counters[Perf_counters::events[i].m_name] = benchmark::Counter(per_op, benchmark::Counter::kAvgThreads);
+                } else {
+                    // Summed over the threads running the variant
+                    m_state.counters[std::string(m_variant) + ":" + Perf_counters::events[i].m_name] = per_op / m_sharing;
+                }
+            }
+        }
+    }
+
+    void pause() noexcept {
+        if (m_active) {
+            m_counters.disable();
+        }
+    }
+
+    void resume() noexcept {
+        if (m_active && !m_stopped) {
+            m_counters.enable();
+        }
+    }
+
+    // Stop counting, for work after the timing loop
+    void stop() noexcept {
+        if (m_active && !m_stopped) {
+            m_counters.disable();
+            m_stopped = true;
+        }
+    }
+
+    Perf_scope(const Perf_scope&) = delete;
+    Perf_scope& operator=(const Perf_scope&) = delete;
+
+private:
+    Perf_scope(benchmark::State& state, const char* variant, int sharing)
+        : m_state(state), m_variant(variant), m_sharing(sharing), m_counters(state.threads() == 1), m_active(m_counters.available()) {
+        if (m_active) {
+            m_counters.reset_and_enable();
+        }
+    }
+
+    benchmark::State& m_state;
+
+    // Variant the counters are reported under and the threads running it
+    const char* m_variant;
+    const int m_sharing;
+
+    Perf_counters m_counters;
+    const bool m_active;
+    bool m_stopped{};
+};
+
+} // namespace bench
@@ -0,0 +1,161 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "work_stealing.h"
+#include "bench_main.h"
+
+// Every worker pushes to and pops from one shared list, the setup we are
+// replacing. Same interface as ut::Work_stealing_pool.
+struct Shared_list_pool {
+    explicit Shared_list_pool(size_t n_workers) {
+        for (size_t i = 0; i < n_workers; ++i) {
+            m_threads.emplace_back([this]() {
+                while (!m_stop.load(std::memory_order_acquire)) {
+                    if (!run_one()) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+    }
+
+    ~Shared_list_pool() {
+        m_stop.store(true, std::memory_order_release);
+        for (auto& thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    void submit(ut::Task* task) {
+        m_tasks.push_front(task);
+    }
+
+    template <typename Done>
+    void wait_until(Done done) {
+        while (!done()) {
+            if (!run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool run_one() {
+        auto task = static_cast<ut::Task*>(m_tasks.pop_front());
+        if (task == nullptr) {
+            return false;
+        }
+        task->execute();
+        return true;
+    }
+
+    ut::Lock_free_list<ut::Task> m_tasks;
+    std::vector<std::thread> m_threads;
+    std::atomic<bool> m_stop{false};
+};
+
+static uint64_t serial_fib(int n) {
+    return n < 2 ? n : serial_fib(n - 1) + serial_fib(n - 2);
+}
+
+// Spawn fib(n - 1), compute fib(n - 2) inline, help until the child is done
+template <typename Pool>
+struct Fib_task : ut::Task {
+    static const int CUTOFF = 12;
+
+    Fib_task(Pool& pool, int n)
+        : m_pool(pool), m_n(n) {}
+
+    void execute() override {
+        m_result = fib(m_pool, m_n);
+        m_done.store(true, std::memory_order_release);
+    }
+
+    static uint64_t fib(Pool& pool, int n) {
+        if (n < CUTOFF) {
+            return serial_fib(n);
+        }
+        Fib_task child(pool, n - 1);
+        pool.submit(&child);
+        const auto other = fib(pool, n - 2);
+        pool.wait_until([&child] { return child.m_done.load(std::memory_order_acquire); });
+        return child.m_result + other;
+    }
+
+    Pool& m_pool;
+    int m_n;
+    uint64_t m_result{};
+    std::atomic<bool> m_done{false};
+};
+
+// Sum a complete binary tree of depth d, both subtrees are spawned
+template <typename Pool>
+struct Tree_sum_task : ut::Task {
+    static const int CUTOFF = 10;
+
+    Tree_sum_task(Pool& pool, int depth, uint64_t id)
+        : m_pool(pool), m_depth(depth), m_id(id) {}
+
+    static uint64_t serial_sum(int depth, uint64_t id) {
+        return depth == 0 ? id : id + serial_sum(depth - 1, 2 * id) + serial_sum(depth - 1, 2 * id + 1);
+    }
+
+    void execute() override {
+        if (m_depth < CUTOFF) {
+            m_result = serial_sum(m_depth, m_id);
+        } else {
+            Tree_sum_task left(m_pool, m_depth - 1, 2 * m_id);
+            Tree_sum_task right(m_pool, m_depth - 1, 2 * m_id + 1);
+            m_pool.submit(&left);
+            m_pool.submit(&right);
+            m_pool.wait_until([&] { return left.m_done.load(std::memory_order_acquire) && right.m_done.load(std::memory_order_acquire); });
+            m_result = m_id + left.m_result + right.m_result;
+        }
+        m_done.store(true, std::memory_order_release);
+    }
+
+    Pool& m_pool;
+    int m_depth;
+    uint64_t m_id;
+    uint64_t m_result{};
+    std::atomic<bool> m_done{false};
+};
+
+template <typename Pool, typename Root>
+static void run_root(Pool& pool, Root& root) {
+    pool.submit(&root);
+    pool.wait_until([&root] { return root.m_done.load(std::memory_order_acquire); });
+    benchmark::DoNotOptimize(root.m_result);
+}
+
+template <typename Pool>
+static void BM_ForkJoinFib(benchmark::State& state) {
+    Pool pool(state.range(0));
+    const int n = state.range(1);
+
+    for (auto _ : state) {
+        Fib_task<Pool> root(pool, n);
+        run_root(pool, root);
+    }
+    state.counters["workers"] = state.range(0);
+}
+BENCHMARK_TEMPLATE(BM_ForkJoinFib, Shared_list_pool)->ArgsProduct({{1, 2, 4, 8, 16}, {25, 30}})->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ForkJoinFib, ut::Work_stealing_pool)->ArgsProduct({{1, 2, 4, 8, 16}, {25, 30}})->UseRealTime();
+
+template <typename Pool>
+static void BM_ForkJoinTreeSum(benchmark::State& state) {
+    Pool pool(state.range(0));
+    const int depth = state.range(1);
+
+    for (auto _ : state) {
+        Tree_sum_task<Pool> root(pool, depth, 1);
+        run_root(pool, root);
+    }
+    state.SetItemsProcessed(state.iterations() * ((int64_t{1} << (depth + 1)) - 1));
+    state.counters["workers"] = state.range(0);
+}
+BENCHMARK_TEMPLATE(BM_ForkJoinTreeSum, Shared_list_pool)->ArgsProduct({{1, 2, 4, 8, 16}, {20}})->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ForkJoinTreeSum, ut::Work_stealing_pool)->ArgsProduct({{1, 2, 4, 8, 16}, {20}})->UseRealTime();
+
+LOCKFREELIST_BENCH_MAIN();
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+namespace bench::ycsb {
+
+// Key distributions and operation mixes of the YCSB core workloads
+// (Cooper et al., "Benchmarking Cloud Serving Systems with YCSB").
+
+enum class Distribution { uniform, zipfian, latest };
+
+inline const char* name(Distribution distribution) {
+    switch (distribution) {
+        case Distribution::uniform: return "uniform";
+        case Distribution::zipfian: return "zipfian";
+        default: return "latest";
+    }
+}
+
+// remove is never drawn, inserts use it to evict older inserts
+enum class Op { read, update, insert, scan, read_modify_write, remove, n_ops };
+
+inline const char* name(Op op) {
+    static constexpr std::array<const char*, size_t(Op::n_ops)> names{
+        "read", "update", "insert", "scan", "rmw", "remove"};
+    return names[size_t(op)];
+}
+
+// Percent of operations of each kind, in Op order, and the key
+// distribution YCSB runs the workload with
+struct Workload {
+    char m_name;
+    std::array<int, size_t(Op::n_ops)> m_mix;
+    Distribution m_distribution;
+};
+
+static constexpr std::array<Workload, 6> workloads{{
+    {'A', {50, 50, 0, 0, 0, 0}, Distribution::zipfian},     // update heavy
+    {'B', {95, 5, 0, 0, 0, 0}, Distribution::zipfian},      // read mostly
+    {'C', {100, 0, 0, 0, 0, 0}, Distribution::zipfian},     // read only
+    {'D', {95, 0, 5, 0, 0, 0}, Distribution::latest},       // read latest
+    {'E', {0, 0, 5, 95, 0, 0}, Distribution::zipfian},      // short ranges
+    {'F', {50, 0, 0, 0, 50, 0}, Distribution::zipfian},     // read-modify-write
+}};
+
+template<typename Rng>
+Op next_op(const Workload& workload, Rng& rng) {
+    int p = std::uniform_int_distribution<int>(0, 99)(rng);
+
+    for (size_t i = 0; i < workload.m_mix.size(); ++i) {
+        if (p < workload.m_mix[i]) {
+            return Op(i);
+        }
+        p -= workload.m_mix[i];
+    }
+    return Op::read;
+}
+
+// Zipfian ranks in [0, n), rank 0 most popular, by the rejection-free method
+// of Gray et al., "Quickly Generating Billion-Record Synthetic Databases".
+// Setup is O(n) for the zeta constant, every draw is O(1).
+class Zipfian {
+public:
+    static constexpr double default_theta = 0.99;
+
+    explicit Zipfian(uint64_t n, double theta = default_theta)
+        : m_n(n), m_alpha(1.0 / (1.0 - theta)), m_zetan(zeta(n, theta)),
+          m_eta((1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta(2, theta) / m_zetan)),
+          m_half_pow_theta(1.0 + std::pow(0.5, theta)) {}
+
+    template<typename Rng>
+    uint64_t operator()(Rng& rng) const {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const double uz = u * m_zetan;
+
+        if (uz < 1.0) {
+            return 0;
+        } else if (uz < m_half_pow_theta) {
+            return 1;
+        }
+        return std::min<uint64_t>(m_n - 1, static_cast<uint64_t>(m_n * std::pow(m_eta * u - m_eta + 1.0, m_alpha)));
+    }
+
+private:
+    static double zeta(uint64_t n, double theta) {
+        double sum = 0;
+
+        for (uint64_t i = 1; i <= n; ++i) {
+            sum += 1.0 / std::pow(double(i), theta);
+        }
+        return sum;
+    }
+
+    const uint64_t m_n;
+    const double m_alpha;
+    const double m_zetan;
+    const double m_eta;
+    const double m_half_pow_theta;
+};
+
+// FNV-1a of the 8 bytes of key
+inline uint64_t fnv_hash(uint64_t key) noexcept {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (int i = 0; i < 8; ++i) {
+        hash ^= key & 0xff;
+        hash *= 0x100000001b3ULL;
+        key >>= 8;
+    }
+    return hash;
+}
+
+// Keys to read or update. Zipfian ranks are hashed so the popular keys are
+// spread over the key space instead of being the oldest ones. Latest is
+// zipfian over insertion order of the keys still in the store, the most
+// recently inserted key is the most popular: the first ranks go to the
+// last live_inserts inserted keys, newest first, the rest to the loaded
+// records, newest first. Keys are dense, inserts take the next one from
+// m_next_key, and the last live_inserts of them must still be stored.
+class Key_chooser {
+public:
+    Key_chooser(Distribution distribution, uint64_t record_count, uint64_t live_inserts, const std::atomic<uint64_t>& next_key)
+        : m_distribution(distribution), m_record_count(record_count), m_live_inserts(live_inserts),
+          m_zipfian(record_count), m_next_key(next_key) {}
+
+    template<typename Rng>
+    uint64_t operator()(Rng& rng) const {
+        switch (m_distribution) {
+            case Distribution::uniform:
+                return std::uniform_int_distribution<uint64_t>(0, m_record_count - 1)(rng);
+            case Distribution::zipfian:
+                return fnv_hash(m_zipfian(rng)) % m_record_count;
+            default: {
+                const auto next = m_next_key.load(std::memory_order_relaxed);
+                const auto window = std::min(next - m_record_count, m_live_inserts);
+                const auto rank = m_zipfian(rng);
+
+                if (rank < window) {
+                    return next - 1 - rank;
+                }
+                return m_record_count - 1 - (rank - window);
+            }
+        }
+    }
+
+private:
+    const Distribution m_distribution;
+    const uint64_t m_record_count;
+    const uint64_t m_live_inserts;
+    const Zipfian m_zipfian;
+    const std::atomic<uint64_t>& m_next_key;
+};
+
+} // namespace bench::ycsb
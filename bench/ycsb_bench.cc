@@ -0,0 +1,316 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "latency_stats.h"
+#include "ycsb.h"
+#include "cpu_topology.h"
+#include "bench_main.h"
+
+// YCSB A-F on key-value stores built from lists. Every run loads
+// record_count keys, then all threads draw operations from the workload mix
+// and keys from the chosen distribution. Inserts add the next key at the
+// front and each thread removes its oldest insert once it has more than
+// insert_window of them, so the store keeps its size. Reads, updates and
+// read-modify-writes that miss their key are counted apart and left out of
+// the latency histograms.
+
+using namespace bench::ycsb;
+
+using clock_type = std::chrono::steady_clock;
+
+// find() compares m_value, so that is the key
+struct Kv_node : public ut::Node {
+    using value_type = uint64_t;
+
+    explicit Kv_node(uint64_t key)
+        : m_value(key) {}
+
+    value_type m_value;
+    std::atomic<uint64_t> m_field{};
+};
+
+using Kv_list = ut::Lock_free_list<Kv_node>;
+
+// Visit up to len nodes from node on
+static size_t scan_from(Kv_list& list, Kv_node* node, size_t len) {
+    size_t visited = 0;
+    uint64_t sum = 0;
+
+    for (Kv_list::iterator it(node, (ut::Node*)node->m_prev.load(std::memory_order_acquire)); it != list.end() && visited < len; ++it) {
+        sum += it->m_field.load(std::memory_order_relaxed);
+        ++visited;
+    }
+    benchmark::DoNotOptimize(sum);
+    return visited;
+}
+
+// All keys in one list, new keys at the front like an LRU chain
+class List_store {
+public:
+    static constexpr const char* name = "list";
+
+    Kv_node* find(uint64_t key) {
+        return static_cast<Kv_node*>(m_list.find(key));
+    }
+
+    void insert(Kv_node* node) {
+        m_list.push_front(node);
+    }
+
+    void remove(Kv_node* node) {
+        m_list.remove(node);
+    }
+
+    size_t scan(uint64_t key, size_t len) {
+        auto node = find(key);
+        return node == nullptr ? 0 : scan_from(m_list, node, len);
+    }
+
+private:
+    Kv_list m_list;
+};
+
+// Chained hash map, one list per bucket. Scans stay in the key's bucket.
+template<size_t Buckets = 64>
+class Hash_store {
+public:
+    static constexpr const char* name = "hash";
+
+    Hash_store() : m_buckets(std::make_unique<Kv_list[]>(Buckets)) {}
+
+    Kv_node* find(uint64_t key) {
+        return static_cast<Kv_node*>(bucket(key).find(key));
+    }
+
+    void insert(Kv_node* node) {
+        bucket(node->m_value).push_front(node);
+    }
+
+    void remove(Kv_node* node) {
+        bucket(node->m_value).remove(node);
+    }
+
+    size_t scan(uint64_t key, size_t len) {
+        auto node = find(key);
+        return node == nullptr ? 0 : scan_from(bucket(key), node, len);
+    }
+
+private:
+    Kv_list& bucket(uint64_t key) {
+        return m_buckets[fnv_hash(key) % Buckets];
+    }
+
+    std::unique_ptr<Kv_list[]> m_buckets;
+};
+
+// Store, records and per-thread state of one run, shared by the
+// benchmark threads
+template<typename Store>
+class Ycsb_run {
+public:
+    static constexpr size_t insert_window = 256;
+    static constexpr size_t max_scan = 100;
+
+    Ycsb_run(const Workload& workload, Distribution distribution, uint64_t record_count, int threads)
+        : m_workload(workload), m_next_key(record_count) {
+
+        for (uint64_t key = 0; key < record_count; ++key) {
+            m_records.push_back(std::make_unique<Kv_node>(key));
+            m_store.insert(m_records.back().get());
+        }
+        // Every thread keeps its last insert_window inserts, so the last
+        // insert_window keys overall are all still in the store
+        for (int t = 0; t < threads; ++t) {
+            m_threads.push_back(std::make_unique<Thread_state>(distribution, record_count, insert_window, m_next_key, t));
+        }
+    }
+
+    void step(int t) {
+        auto& thread = *m_threads[t];
+        const auto op = next_op(m_workload, thread.m_rng);
+
+        switch (op) {
+            case Op::read: {
+                const auto key = thread.m_keys(thread.m_rng);
+                const auto start = clock_type::now();
+                if (auto node = m_store.find(key); node != nullptr) {
+                    benchmark::DoNotOptimize(node->m_field.load(std::memory_order_relaxed));
+                    thread.record(op, start);
+                } else {
+                    ++thread.m_misses;
+                }
+                break;
+            }
+            case Op::update: {
+                const auto key = thread.m_keys(thread.m_rng);
+                const auto start = clock_type::now();
+                if (auto node = m_store.find(key); node != nullptr) {
+                    node->m_field.store(key, std::memory_order_relaxed);
+                    thread.record(op, start);
+                } else {
+                    ++thread.m_misses;
+                }
+                break;
+            }
+            case Op::read_modify_write: {
+                const auto key = thread.m_keys(thread.m_rng);
+                const auto start = clock_type::now();
+                if (auto node = m_store.find(key); node != nullptr) {
+                    node->m_field.fetch_add(1, std::memory_order_relaxed);
+                    thread.record(op, start);
+                } else {
+                    ++thread.m_misses;
+                }
+                break;
+            }
+            case Op::scan: {
+                const auto key = thread.m_keys(thread.m_rng);
+                const auto len = std::uniform_int_distribution<size_t>(1, max_scan)(thread.m_rng);
+                const auto start = clock_type::now();
+                benchmark::DoNotOptimize(m_store.scan(key, len));
+                thread.record(op, start);
+                break;
+            }
+            default: {
+                auto node = thread.recycle(m_next_key.fetch_add(1, std::memory_order_relaxed));
+                const auto start = clock_type::now();
+                m_store.insert(node);
+                thread.record(Op::insert, start);
+
+                thread.m_inserted.push_back(node);
+                if (thread.m_inserted.size() > insert_window) {
+                    const auto evict_start = clock_type::now();
+                    m_store.remove(thread.m_inserted.front());
+                    thread.record(Op::remove, evict_start);
+                    thread.m_inserted.pop_front();
+                }
+                break;
+            }
+        }
+    }
+
+    uint64_t misses() const {
+        uint64_t total = 0;
+
+        for (const auto& thread : m_threads) {
+            total += thread->m_misses;
+        }
+        return total;
+    }
+
+    ut::Latency_histogram histogram(Op op) const {
+        ut::Latency_histogram merged;
+
+        for (const auto& thread : m_threads) {
+            merged += thread->m_histograms[size_t(op)];
+        }
+        return merged;
+    }
+
+private:
+    // Inserts an evicted node stays out of the store before it is reused.
+    // The lists have no reclamation, this only gives readers that still
+    // hold it time to move on.
+    static constexpr size_t reuse_delay = 16 * insert_window;
+
+    struct alignas(64) Thread_state {
+        Thread_state(Distribution distribution, uint64_t record_count, uint64_t live_inserts, const std::atomic<uint64_t>& next_key, int t)
+            : m_keys(distribution, record_count, live_inserts, next_key), m_rng(t + 1) {}
+
+        // Node for a new key. The ring holds the insert_window live inserts
+        // and the reuse_delay evicted after them, so the slot for the next
+        // insert is free or was evicted reuse_delay inserts ago.
+        Kv_node* recycle(uint64_t key) {
+            auto& slot = m_owned[m_next_slot++ % m_owned.size()];
+
+            if (slot == nullptr) {
+                slot = std::make_unique<Kv_node>(key);
+            } else {
+                slot->m_value = key;
+                slot->m_field.store(0, std::memory_order_relaxed);
+            }
+            return slot.get();
+        }
+
+        void record(Op op, clock_type::time_point start) {
+            m_histograms[size_t(op)].record(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start).count());
+        }
+
+        Key_chooser m_keys;
+        std::mt19937_64 m_rng;
+        std::array<ut::Latency_histogram, size_t(Op::n_ops)> m_histograms{};
+
+        uint64_t m_misses{};
+
+        // Nodes this thread inserted, oldest still in the store first
+        std::deque<Kv_node*> m_inserted;
+        std::array<std::unique_ptr<Kv_node>, insert_window + 1 + reuse_delay> m_owned;
+        size_t m_next_slot{};
+    };
+
+    const Workload& m_workload;
+    std::atomic<uint64_t> m_next_key;
+    Store m_store;
+    std::vector<std::unique_ptr<Kv_node>> m_records;
+    std::vector<std::unique_ptr<Thread_state>> m_threads;
+};
+
+// Workload state.range(0) with Distribution state.range(1) on
+// state.range(2) records. Thread 0 loads the store before the timing loop
+// and reports p50/p99/p99.9 in ns of every operation kind after it.
+template<typename Store>
+static void BM_Ycsb(benchmark::State& state) {
+    static std::unique_ptr<Ycsb_run<Store>> run;
+    const auto& workload = workloads[state.range(0)];
+    const auto distribution = Distribution(state.range(1));
+    bench::Pin_scope pin(state.thread_index());
+
+    if (state.thread_index() == 0) {
+        run = std::make_unique<Ycsb_run<Store>>(workload, distribution, state.range(2), state.threads());
+    }
+
+    for (auto _ : state) {
+        run->step(state.thread_index());
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        state.SetLabel(std::string(1, workload.m_name) + " " + name(distribution) + " " + Store::name);
+        state.counters["misses/op"] = benchmark::Counter(double(run->misses()), benchmark::Counter::kAvgIterations);
+
+        for (size_t i = 0; i < size_t(Op::n_ops); ++i) {
+            const auto summary = run->histogram(Op(i)).summary();
+
+            if (summary.m_count == 0) {
+                continue;
+            }
+
+            const std::string op = name(Op(i));
+            state.counters[op + "_p50_ns"] = summary.m_p50;
+            state.counters[op + "_p99_ns"] = summary.m_p99;
+            state.counters[op + "_p999_ns"] = summary.m_p999;
+        }
+        run.reset();
+    }
+}
+
+// Every workload with its YCSB distribution and with uniform keys
+static void ycsb_args(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"workload", "dist", "records"});
+
+    for (size_t w = 0; w < workloads.size(); ++w) {
+        b->Args({int64_t(w), int64_t(workloads[w].m_distribution), 1000});
+        b->Args({int64_t(w), int64_t(Distribution::uniform), 1000});
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_Ycsb, List_store)->Apply(ycsb_args)->Threads(1)->Threads(4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Ycsb, Hash_store<>)->Apply(ycsb_args)->Threads(1)->Threads(4)->UseRealTime();
+
+LOCKFREELIST_BENCH_MAIN();
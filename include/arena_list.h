@@ -0,0 +1,457 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "relaxed_copy.h"
+
+namespace ut {
+
+/* Lock-free list whose nodes live in a fixed size arena. A link is a 32-bit
+arena index, a removed mark and a 31-bit version in one 64-bit CAS word, so
+a hook is 12 bytes instead of two 8-byte tagged pointers and a vptr, and
+every change to a link bumps its version: a CAS with a stale link word
+fails even if the index it names was freed and handed out again.
+
+Removal marks the node's next word first and then unlinks it from its
+predecessor (Harris-Michael), whoever unlinks a node returns it to the
+arena. Arena memory is never released while the list is alive, so a reader
+that lands on a recycled node still reads valid memory.
+
+A recycled node's value can be rewritten while a reader copies it, so
+values are only read and written with relaxed atomic accesses and a reader
+only keeps what it read past an unmarked node if that node's next word is
+unchanged afterwards, like a seqlock. Recycling a node changes the next
+word of every node it could have been reached from. Iteration is weakly
+consistent while there are writers: if the node an iterator stands on is
+removed before it moves on, it starts over from the head and can return
+values again. Values are copied in and out, T must be trivially copyable. */
+template <typename T>
+struct Arena_list {
+  static_assert(std::is_trivially_copyable_v<T>, "Values are copied in and out of nodes");
+
+  static constexpr uint32_t null_index = ~uint32_t{};
+
+  /* Link word: low 32 bits index, bit 32 the removed mark, bits 33..63 version */
+  static constexpr uint64_t index_mask = 0xFFFFFFFF;
+  static constexpr uint64_t marked_bit = uint64_t{1} << 32;
+  static constexpr uint64_t version_one = uint64_t{1} << 33;
+
+  static constexpr uint32_t index_of(uint64_t word) noexcept {
+    return uint32_t(word & index_mask);
+  }
+
+  static constexpr bool is_marked(uint64_t word) noexcept {
+    return (word & marked_bit) != 0;
+  }
+
+  /* Same link pointing at index, next version, mark cleared */
+  static constexpr uint64_t relink(uint64_t word, uint32_t index) noexcept {
+    return ((word & ~(index_mask | marked_bit)) + version_one) | index;
+  }
+
+  /* Same link, next version, mark set */
+  static constexpr uint64_t mark(uint64_t word) noexcept {
+    return (word + version_one) | marked_bit;
+  }
+
+  struct Arena_node {
+    std::atomic<uint64_t> m_next{};
+
+    /* Predecessor when the node was linked or its successor last unlinked,
+    only a hint for remove() */
+    std::atomic<uint32_t> m_prev{};
+
+    T m_value{};
+  };
+
+  /* Forward iterator over copies of the values, removed nodes are skipped */
+  struct const_iterator {
+    using value_type = T;
+    using pointer = const T*;
+    using reference = const T&;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    const_iterator() noexcept = default;
+
+    /* Start at the head sentinel and move to the first value */
+    explicit const_iterator(const Arena_list* list) noexcept
+      : m_list(list), m_index(0), m_word(list->m_nodes[0].m_next.load(std::memory_order_acquire)) {
+      advance();
+    }
+
+    reference operator*() const noexcept {
+      return m_value;
+    }
+
+    pointer operator->() const noexcept {
+      return &m_value;
+    }
+
+    /* Arena index of the current node */
+    uint32_t index() const noexcept {
+      return m_index;
+    }
+
+    const_iterator& operator++() noexcept {
+      advance();
+      return *this;
+    }
+
+    const_iterator operator++(int) noexcept {
+      auto tmp = *this;
+
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const const_iterator& rhs) const noexcept {
+      return m_index == rhs.m_index;
+    }
+
+    bool operator!=(const const_iterator& rhs) const noexcept {
+      return !(*this == rhs);
+    }
+
+    /* Move from m_index to the next unmarked node and copy its value.
+    m_index was unmarked, so linked, when m_word was read. Whatever we read
+    past it is only kept if m_index still has m_word afterwards: then every
+    node up to the one we read was linked the whole time, a marked node's
+    next word cannot change while it is linked, and none of them was
+    recycled. */
+    void advance() noexcept {
+      const auto& nodes = m_list->m_nodes;
+      auto next = index_of(m_word);
+
+      while (next != null_index) {
+        const auto word = nodes[next].m_next.load(std::memory_order_acquire);
+
+        if (auto after = index_of(word); after != null_index) {
+          __builtin_prefetch(&nodes[after], 0, 3);
+        }
+
+        T value{};
+
+        if (!is_marked(word)) {
+          value = detail::load_relaxed(nodes[next].m_value);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (const auto now = nodes[m_index].m_next.load(std::memory_order_relaxed); now != m_word) {
+          /* Our successor was unlinked, go on from the new one. If we were
+          removed ourselves nothing past us can be trusted. */
+          if (is_marked(now)) {
+            m_index = 0;
+            m_word = nodes[0].m_next.load(std::memory_order_acquire);
+          } else {
+            m_word = now;
+          }
+          next = index_of(m_word);
+          continue;
+        }
+
+        if (!is_marked(word)) {
+          m_index = next;
+          m_word = word;
+          m_value = value;
+          return;
+        }
+        next = index_of(word);
+      }
+      m_index = null_index;
+    }
+
+    const Arena_list* m_list{};
+
+    uint32_t m_index{null_index};
+
+    /* Next word of m_index read when we stepped onto it */
+    uint64_t m_word{};
+
+    /* Copy of m_index's value, validated against m_word */
+    T m_value{};
+  };
+
+  /* Arena with room for capacity values, index 0 is the head sentinel */
+  explicit Arena_list(uint32_t capacity)
+    : m_capacity(capacity),
+      m_nodes(std::make_unique<Arena_node[]>(size_t(capacity) + 1)) {
+    assert(capacity < null_index);
+
+    m_nodes[0].m_next.store(null_index, std::memory_order_relaxed);
+
+    /* Free nodes keep their next word marked so readers skip them */
+    for (uint32_t i = 1; i <= capacity; ++i) {
+      m_nodes[i].m_next.store(marked_bit | (i < capacity ? i + 1 : null_index), std::memory_order_relaxed);
+    }
+
+    m_free.store(capacity > 0 ? 1 : null_index, std::memory_order_release);
+  }
+
+  Arena_list(const Arena_list&) = delete;
+  Arena_list& operator=(const Arena_list&) = delete;
+
+  /* Add a value to the front. Returns its arena index, or null_index if the
+  arena is full. */
+  uint32_t push_front(const T& value) {
+    const auto index = allocate();
+
+    if (index == null_index) {
+      return null_index;
+    }
+
+    auto& node = m_nodes[index];
+
+    /* Readers still on the old incarnation check a next word that changed
+    when it was unlinked, the fence makes them see that change if they see
+    the new value */
+    std::atomic_thread_fence(std::memory_order_release);
+    detail::store_relaxed(node.m_value, value);
+    node.m_prev.store(0, std::memory_order_relaxed);
+
+    auto head = m_nodes[0].m_next.load(std::memory_order_acquire);
+
+    for (;;) {
+      node.m_next.store(relink(node.m_next.load(std::memory_order_relaxed), index_of(head)), std::memory_order_release);
+
+      if (m_nodes[0].m_next.compare_exchange_weak(head, relink(head, index), std::memory_order_release, std::memory_order_acquire)) {
+        break;
+      }
+    }
+
+    if (auto next = index_of(head); next != null_index) {
+      m_nodes[next].m_prev.store(index, std::memory_order_relaxed);
+    }
+    return index;
+  }
+
+  /* Remove the node at index. Returns false if it was already removed. The
+  index must have come from push_front() or an iterator of this list. */
+  bool remove(uint32_t index) {
+    assert(index != 0 && index <= m_capacity);
+
+    auto& node = m_nodes[index];
+    auto word = node.m_next.load(std::memory_order_acquire);
+
+    do {
+      if (is_marked(word)) {
+        return false;
+      }
+    } while (!node.m_next.compare_exchange_weak(word, mark(word), std::memory_order_acq_rel, std::memory_order_acquire));
+
+    unlink(index, mark(word));
+    return true;
+  }
+
+  /* Remove the first value matching pred and copy it to out */
+  template <typename Predicate>
+  bool remove_if(Predicate pred, T& out) {
+    for (;;) {
+      uint32_t pred_index;
+      uint64_t pred_word;
+      uint64_t word;
+      T value;
+
+      if (!locate([&](uint32_t i) { value = detail::load_relaxed(m_nodes[i].m_value); return pred(value); }, pred_index, pred_word, word)) {
+        return false;
+      }
+
+      const auto index = index_of(pred_word);
+
+      /* The value and word were read while the node was linked after
+      pred_index, a failed mark means it was removed or recycled meanwhile */
+      if (!m_nodes[index].m_next.compare_exchange_strong(word, mark(word), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        continue;
+      }
+
+      out = value;
+
+      /* Fast unlink from the predecessor we found, else let unlink() search */
+      if (m_nodes[pred_index].m_next.compare_exchange_strong(pred_word, relink(pred_word, index_of(word)), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        unlinked(pred_index, index, index_of(word));
+      } else {
+        unlink(index, mark(word));
+      }
+      return true;
+    }
+  }
+
+  template <typename Predicate>
+  bool remove_if(Predicate pred) {
+    T value;
+
+    return remove_if(pred, value);
+  }
+
+  /* Arena index of the first value matching pred, or null_index */
+  template <typename Predicate>
+  uint32_t find_if(Predicate pred) const {
+    for (auto it = begin(); it != end(); ++it) {
+      if (pred(*it)) {
+        return it.index();
+      }
+    }
+    return null_index;
+  }
+
+  /* Copy of the value at index, only meaningful while it is in the list */
+  T operator[](uint32_t index) const noexcept {
+    return detail::load_relaxed(m_nodes[index].m_value);
+  }
+
+  /* Number of linked values, exact only when there are no writers */
+  size_t size() const noexcept {
+    size_t n{};
+
+    for (auto it = begin(); it != end(); ++it) {
+      ++n;
+    }
+    return n;
+  }
+
+  bool empty() const noexcept {
+    return begin() == end();
+  }
+
+  uint32_t capacity() const noexcept {
+    return m_capacity;
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(this);
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator();
+  }
+
+  /* Walk from the head unlinking marked nodes on the way, until an unmarked
+  node matches. On success pred_word is the link word of pred_index that
+  points at the match and word is the match's own next word, both read
+  before and after match() looked at it. */
+  template <typename Match>
+  bool locate(Match match, uint32_t& pred_index, uint64_t& pred_word, uint64_t& word) {
+  restart:
+    pred_index = 0;
+    pred_word = m_nodes[0].m_next.load(std::memory_order_acquire);
+
+    while (index_of(pred_word) != null_index) {
+      const auto current = index_of(pred_word);
+
+      word = m_nodes[current].m_next.load(std::memory_order_acquire);
+
+      if (is_marked(word)) {
+        /* Help unlink, if pred moved on restart, the version tells us */
+        auto expected = pred_word;
+
+        if (!m_nodes[pred_index].m_next.compare_exchange_strong(expected, relink(pred_word, index_of(word)), std::memory_order_acq_rel, std::memory_order_acquire)) {
+          goto restart;
+        }
+        unlinked(pred_index, current, index_of(word));
+        pred_word = relink(pred_word, index_of(word));
+        continue;
+      }
+
+      const bool matched = match(current);
+
+      /* pred still pointing at current with the same version means current
+      was linked the whole time, so word and the value are its own */
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (m_nodes[pred_index].m_next.load(std::memory_order_relaxed) != pred_word) {
+        goto restart;
+      }
+
+      if (matched) {
+        return true;
+      }
+
+      pred_index = current;
+      pred_word = word;
+    }
+    return false;
+  }
+
+  /* Unlink a node that we marked, marked_word is its next word after marking */
+  void unlink(uint32_t index, uint64_t marked_word) {
+    /* Try the predecessor hint first */
+    const auto hint = m_nodes[index].m_prev.load(std::memory_order_relaxed);
+    auto expected = m_nodes[hint].m_next.load(std::memory_order_acquire);
+
+    /* The hint still pointing at index after we read that the node was
+    not released yet means it points at this incarnation, and a marked
+    node's next word does not change until it is released */
+    if (index_of(expected) == index && !is_marked(expected) && m_nodes[index].m_next.load(std::memory_order_acquire) == marked_word) {
+      const auto next = index_of(marked_word);
+
+      if (m_nodes[hint].m_next.compare_exchange_strong(expected, relink(expected, next), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        unlinked(hint, index, next);
+        return;
+      }
+    }
+
+    /* Searching unlinks every marked node it passes, including ours,
+    unless a concurrent search got to it first */
+    uint32_t pred_index;
+    uint64_t pred_word;
+    uint64_t word;
+
+    locate([index](uint32_t i) { return i == index; }, pred_index, pred_word, word);
+  }
+
+  /* index was unlinked from between pred and next by our CAS */
+  void unlinked(uint32_t pred, uint32_t index, uint32_t next) noexcept {
+    if (next != null_index) {
+      m_nodes[next].m_prev.store(pred, std::memory_order_relaxed);
+    }
+    release(index);
+  }
+
+  /* Pop a node off the arena free list */
+  uint32_t allocate() noexcept {
+    auto free = m_free.load(std::memory_order_acquire);
+
+    for (;;) {
+      const auto index = index_of(free);
+
+      if (index == null_index) {
+        return null_index;
+      }
+
+      /* May read a node another thread just took, the version makes our CAS fail */
+      const auto next = index_of(m_nodes[index].m_next.load(std::memory_order_acquire));
+
+      if (m_free.compare_exchange_weak(free, relink(free, next), std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return index;
+      }
+    }
+  }
+
+  /* Push an unlinked node onto the free list, its next word stays marked */
+  void release(uint32_t index) noexcept {
+    auto& node = m_nodes[index];
+    auto free = m_free.load(std::memory_order_acquire);
+
+    for (;;) {
+      node.m_next.store(mark(relink(node.m_next.load(std::memory_order_relaxed), index_of(free))), std::memory_order_relaxed);
+
+      if (m_free.compare_exchange_weak(free, relink(free, index), std::memory_order_release, std::memory_order_acquire)) {
+        return;
+      }
+    }
+  }
+
+  const uint32_t m_capacity;
+
+  std::unique_ptr<Arena_node[]> m_nodes;
+
+  /* Top of the free list, index and version like a link */
+  alignas(64) std::atomic<uint64_t> m_free{};
+};
+
+} // namespace ut
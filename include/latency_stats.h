@@ -0,0 +1,279 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <ostream>
+
+#include "lockfreelist.h"
+
+namespace ut {
+
+/* Log-linear bucketing in the style of HdrHistogram. Values below
+2 * sub_buckets get a bucket each, above that every power of two is split
+into sub_buckets equal buckets, so a bucket is at most 1/sub_buckets of its
+value wide. Values past max_exponent land in the last bucket. */
+struct Latency_buckets {
+  static constexpr unsigned sub_bits = 4;
+  static constexpr uint64_t sub_buckets = uint64_t{1} << sub_bits;
+
+  /* 2^40 ns is about 18 minutes */
+  static constexpr unsigned max_exponent = 40;
+
+  static constexpr size_t n_buckets = (max_exponent - sub_bits) * sub_buckets + 2 * sub_buckets;
+
+  static constexpr size_t index(uint64_t value) noexcept {
+    if (value < 2 * sub_buckets) {
+      return value;
+    }
+
+    const unsigned exponent = std::bit_width(value) - 1;
+
+    if (exponent > max_exponent) {
+      return n_buckets - 1;
+    }
+
+    return (exponent - sub_bits) * sub_buckets + (value >> (exponent - sub_bits));
+  }
+
+  static constexpr uint64_t lower_bound(size_t index) noexcept {
+    if (index < 2 * sub_buckets) {
+      return index;
+    }
+
+    const unsigned exponent = index / sub_buckets + sub_bits - 1;
+
+    return (index - (exponent - sub_bits) * sub_buckets) << (exponent - sub_bits);
+  }
+
+  /* Largest value that maps to index */
+  static constexpr uint64_t upper_bound(size_t index) noexcept {
+    return index + 1 == n_buckets ? UINT64_MAX : lower_bound(index + 1) - 1;
+  }
+};
+
+/* p50/p99/p99.9/max of a Latency_histogram, in nanoseconds */
+struct Latency_summary {
+  uint64_t m_count{};
+  uint64_t m_p50{};
+  uint64_t m_p99{};
+  uint64_t m_p999{};
+  uint64_t m_max{};
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Latency_summary& summary) {
+  return out << "count=" << summary.m_count
+             << " p50=" << summary.m_p50 << "ns"
+             << " p99=" << summary.m_p99 << "ns"
+             << " p99.9=" << summary.m_p999 << "ns"
+             << " max=" << summary.m_max << "ns";
+}
+
+/* Merged latencies of one operation */
+struct Latency_histogram {
+  uint64_t count() const noexcept {
+    uint64_t total{};
+
+    for (auto n : m_counts) {
+      total += n;
+    }
+    return total;
+  }
+
+  /* Smallest value v such that at least fraction of the samples are <= v,
+  rounded up to the end of its bucket and capped at the exact maximum */
+  uint64_t percentile(double fraction) const noexcept {
+    const auto total = count();
+
+    if (total == 0) {
+      return 0;
+    }
+
+    const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * total + 0.5));
+    uint64_t seen{};
+
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+      seen += m_counts[i];
+
+      if (seen >= rank) {
+        return std::min(Latency_buckets::upper_bound(i), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  Latency_summary summary() const noexcept {
+    return {count(), percentile(0.5), percentile(0.99), percentile(0.999), m_max};
+  }
+
+  /* Unsynchronized, for a histogram owned by one thread */
+  void record(uint64_t ns) noexcept {
+    ++m_counts[Latency_buckets::index(ns)];
+    m_max = std::max(m_max, ns);
+  }
+
+  Latency_histogram& operator+=(const Latency_histogram& rhs) noexcept {
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+      m_counts[i] += rhs.m_counts[i];
+    }
+    m_max = std::max(m_max, rhs.m_max);
+    return *this;
+  }
+
+  std::array<uint64_t, Latency_buckets::n_buckets> m_counts{};
+  uint64_t m_max{};
+};
+
+/* Stats policy for Lock_free_list that records the latency of every
+push_front, push_back, insert_after, remove, pop_front and find_if call into
+a log-linear histogram per operation. Like Contention_stats threads record
+into shard thread_index() % Shards with relaxed increments, so with more
+threads than shards some share one and its cache lines, and reads merge the
+shards. A shard holds every operation's histogram, about 29KB, so all 8
+default shards take about 233KB. Each is only allocated when a thread first
+records into it, a list with few threads pays for few shards. */
+template <size_t Shards = 8>
+struct Latency_stats : No_stats {
+  static_assert(Shards > 0, "Need at least one shard");
+
+  static constexpr size_t n_ops = List_stats::n_ops;
+
+  using clock = std::chrono::steady_clock;
+
+  struct alignas(64) Shard {
+    std::array<std::array<std::atomic<uint64_t>, Latency_buckets::n_buckets>, n_ops> m_counts{};
+    std::array<std::atomic<uint64_t>, n_ops> m_max{};
+  };
+
+  /* Records the time from construction to destruction */
+  struct Timer {
+    Timer(Latency_stats* stats, List_op op) noexcept
+      : m_stats(stats), m_op(op), m_start(clock::now()) {}
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    ~Timer() {
+      m_stats->record(m_op, std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count());
+    }
+
+    Latency_stats* m_stats;
+    List_op m_op;
+    clock::time_point m_start;
+  };
+
+  Latency_stats() = default;
+
+  Latency_stats(const Latency_stats&) = delete;
+  Latency_stats& operator=(const Latency_stats&) = delete;
+
+  ~Latency_stats() {
+    for (auto& shard : m_shards) {
+      delete shard.load(std::memory_order_relaxed);
+    }
+  }
+
+  Timer time(List_op op) noexcept {
+    return Timer(this, op);
+  }
+
+  /* The calling thread's shard, allocated on first use. nullptr only if
+  that allocation failed, the sample is then dropped. */
+  Shard* local_shard() noexcept {
+    auto& slot = m_shards[detail::thread_index() % Shards];
+    auto shard = slot.load(std::memory_order_acquire);
+
+    if (shard == nullptr) {
+      auto fresh = new (std::nothrow) Shard{};
+
+      if (fresh == nullptr) {
+        return nullptr;
+      }
+
+      if (slot.compare_exchange_strong(shard, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        shard = fresh;
+      } else {
+        delete fresh;
+      }
+    }
+    return shard;
+  }
+
+  void record(List_op op, uint64_t ns) noexcept {
+    auto shard_ptr = local_shard();
+
+    if (shard_ptr == nullptr) {
+      return;
+    }
+
+    auto& shard = *shard_ptr;
+    const auto i = static_cast<size_t>(op);
+
+    shard.m_counts[i][Latency_buckets::index(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    auto max = shard.m_max[i].load(std::memory_order_relaxed);
+
+    while (ns > max && !shard.m_max[i].compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+  }
+
+  Latency_histogram histogram(List_op op) const noexcept {
+    Latency_histogram merged;
+    const auto i = static_cast<size_t>(op);
+
+    for (const auto& slot : m_shards) {
+      const auto shard = slot.load(std::memory_order_acquire);
+
+      if (shard == nullptr) {
+        continue;
+      }
+
+      for (size_t b = 0; b < Latency_buckets::n_buckets; ++b) {
+        merged.m_counts[b] += shard->m_counts[i][b].load(std::memory_order_relaxed);
+      }
+      merged.m_max = std::max(merged.m_max, shard->m_max[i].load(std::memory_order_relaxed));
+    }
+
+    return merged;
+  }
+
+  void reset() noexcept {
+    for (const auto& slot : m_shards) {
+      const auto shard = slot.load(std::memory_order_acquire);
+
+      if (shard == nullptr) {
+        continue;
+      }
+
+      for (auto& counts : shard->m_counts) {
+        for (auto& count : counts) {
+          count.store(0, std::memory_order_relaxed);
+        }
+      }
+      for (auto& max : shard->m_max) {
+        max.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /* Number of shards allocated so far */
+  size_t allocated_shards() const noexcept {
+    return std::count_if(m_shards.begin(), m_shards.end(), [](const auto& slot) {
+      return slot.load(std::memory_order_relaxed) != nullptr;
+    });
+  }
+
+  std::array<std::atomic<Shard*>, Shards> m_shards{};
+};
+
+/* Merged latencies of op on a list with Latency_stats */
+template <typename T, Concurrency M, size_t Shards, bool B>
+Latency_histogram latencies(const Lock_free_list<T, M, Latency_stats<Shards>, B>& list, List_op op) noexcept {
+  return list.m_stats.histogram(op);
+}
+
+} // namespace ut
@@ -1,27 +1,56 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
 #include <iostream>
 #include <memory>
 #include <vector>
 #include <thread>
 #include <cassert>
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* USDT probes for perf and bpftrace, in the lockfreelist provider: each
+probe is a single NOP until a tracer attaches. Define LOCKFREELIST_USDT
+(the LOCKFREELIST_USDT CMake option) and install <sys/sdt.h> from
+systemtap-sdt-dev to get them, otherwise they compile to nothing. */
+#if defined(LOCKFREELIST_USDT) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define LOCKFREELIST_PROBE(name, ...) STAP_PROBEV(lockfreelist, name, __VA_ARGS__)
+#else
+#define LOCKFREELIST_PROBE(name, ...) ((void)0)
+#endif
 
 namespace ut {
 
-struct Node {
+/* 16 byte aligned so that the low 4 bits of a node address can carry the
+version of a link to it */
+struct alignas(16) Node {
 
   struct Tag {
-    static constexpr uintptr_t version_mask = 0x4;
+    static constexpr uintptr_t version_mask = 0xF;
     static constexpr uintptr_t ptr_mask = 0xFFFFFFFFFFFFFFF0;
 
     Tag() noexcept = default;
 
+    /* The version wraps, it only has to differ from the last few */
     explicit Tag(uintptr_t ptr, uintptr_t version) noexcept
-      : m_ptr(ptr & ptr_mask) {
-      assert(version < (1u << 4) - 1);
-      m_ptr |= version;
-    }
+      : m_ptr((ptr & ptr_mask) | (version & version_mask)) {}
 
     explicit Tag(Node* ptr, uintptr_t version) noexcept
       : Tag(reinterpret_cast<uintptr_t>(ptr), version) {}
@@ -39,10 +68,12 @@ struct Node {
     }
 
     Tag next_version() const noexcept {
-      const auto v = version();
-      assert(v < (1u << 4) - 1);  
+      return Tag(m_ptr, version() + 1);
+    }
 
-      return Tag(m_ptr, v + 1);
+    /* Same version, pointing at ptr */
+    Tag with_ptr(Node* ptr) const noexcept {
+      return Tag(ptr, version());
     }
 
     uintptr_t m_ptr{};
@@ -79,11 +110,334 @@ struct Node {
   std::atomic<Tag> m_prev{};
 };
 
-template <typename T>
+/* Node stamped with the list epoch at which it was inserted and removed,
+derive from this instead of Node to use Lock_free_list::snapshot(). A node
+is visible to a snapshot taken at epoch E if it was inserted at or before E
+and removed after E. The insert epoch is only fixed once the node is
+linked, by its inserter or by the first snapshot that reaches it, so every
+pass of a snapshot agrees on it. */
+struct Versioned_node : Node {
+  /* Set on m_remove_epoch by whoever will physically unlink the node */
+  static constexpr uint64_t unlink_claimed = uint64_t{1} << 63;
+
+  /* Set on m_remove_epoch once the node is off the list */
+  static constexpr uint64_t unlinked = uint64_t{1} << 62;
+
+  static constexpr uint64_t epoch_mask = unlinked - 1;
+
+  /* Remove epoch of a node that is still in the list */
+  static constexpr uint64_t live = epoch_mask;
+
+  /* Insert epoch of a node that is being linked */
+  static constexpr uint64_t pending = epoch_mask;
+
+  /* The epoch the node was inserted at. Once the node is linked the first
+  caller fixes a pending epoch to the list epoch it reads, a snapshot that
+  gets there before the inserter reads an epoch past its own and so never
+  sees the node. */
+  uint64_t settle_insert_epoch(const std::atomic<uint64_t>& list_epoch) noexcept {
+    auto epoch = m_insert_epoch.load(std::memory_order_acquire);
+
+    if (epoch == pending) {
+      const auto now = list_epoch.load(std::memory_order_seq_cst);
+
+      if (m_insert_epoch.compare_exchange_strong(epoch, now, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return now;
+      }
+    }
+    return epoch;
+  }
+
+  bool visible_at(uint64_t epoch, const std::atomic<uint64_t>& list_epoch) noexcept {
+    return settle_insert_epoch(list_epoch) <= epoch
+      && (m_remove_epoch.load(std::memory_order_acquire) & epoch_mask) > epoch;
+  }
+
+  bool is_removed() const noexcept {
+    return (m_remove_epoch.load(std::memory_order_acquire) & epoch_mask) != live;
+  }
+
+  /* A removed node may only be freed once this returns true */
+  bool is_unlinked() const noexcept {
+    return (m_remove_epoch.load(std::memory_order_acquire) & unlinked) != 0;
+  }
+
+  /* Returns true if the caller won the right to unlink the node */
+  bool claim_unlink() noexcept {
+    auto epoch = m_remove_epoch.load(std::memory_order_acquire);
+
+    while ((epoch & unlink_claimed) == 0) {
+      if (m_remove_epoch.compare_exchange_weak(epoch, epoch | unlink_claimed, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::atomic<uint64_t> m_insert_epoch{};
+  std::atomic<uint64_t> m_remove_epoch{live};
+};
+
+/* Node for Striped_lock_free_list, derive from this instead of Node. push()
+records the stripe it put the node on so remove() can go straight to it. */
+struct Striped_node : Node {
+  uint32_t m_stripe{};
+};
+
+/* A coroutine parked in Lock_free_list::next(). Whoever pops a node for it
+stores the node in m_node and then calls m_wake, which hands the coroutine
+to its executor. */
+struct List_waiter {
+  List_waiter* m_next{};
+  Node* m_node{};
+  void (*m_wake)(List_waiter*){};
+  std::coroutine_handle<> m_handle{};
+};
+
+/* Resumes the coroutine on the thread that pushed the node, inside its
+push. Only for consumers that are cheap and never block. */
+struct Inline_executor {
+  void operator()(std::coroutine_handle<> handle) const {
+    handle.resume();
+  }
+};
+
+/* The default executor of Lock_free_list::next(): queues the coroutine on
+the list, to be resumed by resume_woken() on a thread of the consumer's
+choosing */
+struct Queue_executor {};
+
+/* Which threads may use a list concurrently. MPMC is the general list.
+The other modes make it a FIFO queue that only supports push_back() and
+pop_front(): producers append with one exchange on the tail and a release
+store of the link, a single consumer advances the head with plain stores
+and multiple consumers claim the head with a CAS. Producers need the
+exchange even when there is only one of them, because the consumer takes
+the tail back when it pops the last node. */
+enum class Concurrency { SPSC, MPSC, SPMC, MPMC };
+
+/* Operations counted by Contention_stats */
+enum class List_op { push_front, push_back, insert_after, remove, pop_front, find_if, n_ops };
+
+/* Point in time totals of a Contention_stats, attempts counts every pass
+through an operation's retry loop so attempts - calls is the number of
+retries */
+struct List_stats {
+  static constexpr size_t n_ops = static_cast<size_t>(List_op::n_ops);
+
+  uint64_t calls(List_op op) const noexcept {
+    return m_calls[static_cast<size_t>(op)];
+  }
+
+  uint64_t attempts(List_op op) const noexcept {
+    return m_attempts[static_cast<size_t>(op)];
+  }
+
+  uint64_t cas_failures(List_op op) const noexcept {
+    return m_cas_failures[static_cast<size_t>(op)];
+  }
+
+  std::array<uint64_t, n_ops> m_calls{};
+  std::array<uint64_t, n_ops> m_attempts{};
+  std::array<uint64_t, n_ops> m_cas_failures{};
+
+  /* remove() found a neighbour's link changed and started over */
+  uint64_t m_remove_retries{};
+
+  /* A bidirectional iterator found its node unlinked and walked on */
+  uint64_t m_iterator_recoveries{};
+
+  /* push_back() found a node after the tail, the tail had not caught up */
+  uint64_t m_tail_lags{};
+};
+
+/* Returned by Lock_free_list::time_op() when the policy keeps no latencies */
+struct No_timer {};
+
+/* Default stats policy of Lock_free_list, counts nothing and takes no space */
+struct No_stats {
+  static constexpr bool enabled = false;
+
+  void call(List_op) noexcept {}
+  void attempt(List_op) noexcept {}
+  void cas_failure(List_op) noexcept {}
+  void remove_retry() noexcept {}
+  void iterator_recovery() noexcept {}
+  void tail_lag() noexcept {}
+
+  List_stats snapshot() const noexcept {
+    return {};
+  }
+
+  void reset() noexcept {}
+};
+
+namespace detail {
+
+/* Small per-thread index, handed out round robin on first use */
+inline size_t thread_index() noexcept {
+  static std::atomic<size_t> next{};
+  thread_local const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+
+  return index;
+}
+
+} // namespace detail
+
+/* Stats policy that counts attempts, CAS failures and retries. Threads
+count into their own cache line aligned shard so that counting does not
+add contention of its own, more threads than Shards share shards. A
+snapshot sums the shards and is not atomic with respect to counting. */
+template <size_t Shards = 32>
+struct Contention_stats {
+  static_assert(Shards > 0, "Need at least one shard");
+
+  static constexpr bool enabled = true;
+
+  static constexpr size_t n_ops = List_stats::n_ops;
+
+  /* Counter slots in a shard */
+  static constexpr size_t calls_slot = 0;
+  static constexpr size_t attempts_slot = calls_slot + n_ops;
+  static constexpr size_t cas_failures_slot = attempts_slot + n_ops;
+  static constexpr size_t remove_retries_slot = cas_failures_slot + n_ops;
+  static constexpr size_t iterator_recoveries_slot = remove_retries_slot + 1;
+  static constexpr size_t tail_lags_slot = iterator_recoveries_slot + 1;
+  static constexpr size_t n_slots = tail_lags_slot + 1;
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, n_slots> m_counters{};
+  };
+
+  void call(List_op op) noexcept {
+    add(calls_slot + static_cast<size_t>(op));
+  }
+
+  void attempt(List_op op) noexcept {
+    add(attempts_slot + static_cast<size_t>(op));
+  }
+
+  void cas_failure(List_op op) noexcept {
+    add(cas_failures_slot + static_cast<size_t>(op));
+  }
+
+  void remove_retry() noexcept {
+    add(remove_retries_slot);
+  }
+
+  void iterator_recovery() noexcept {
+    add(iterator_recoveries_slot);
+  }
+
+  void tail_lag() noexcept {
+    add(tail_lags_slot);
+  }
+
+  List_stats snapshot() const noexcept {
+    List_stats stats;
+
+    for (const auto& shard : m_shards) {
+      auto value = [&shard](size_t slot) {
+        return shard.m_counters[slot].load(std::memory_order_relaxed);
+      };
+
+      for (size_t op = 0; op < n_ops; ++op) {
+        stats.m_calls[op] += value(calls_slot + op);
+        stats.m_attempts[op] += value(attempts_slot + op);
+        stats.m_cas_failures[op] += value(cas_failures_slot + op);
+      }
+
+      stats.m_remove_retries += value(remove_retries_slot);
+      stats.m_iterator_recoveries += value(iterator_recoveries_slot);
+      stats.m_tail_lags += value(tail_lags_slot);
+    }
+
+    return stats;
+  }
+
+  void reset() noexcept {
+    for (auto& shard : m_shards) {
+      for (auto& counter : shard.m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void add(size_t slot) noexcept {
+    m_shards[detail::thread_index() % Shards].m_counters[slot].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::array<Shard, Shards> m_shards{};
+};
+
+/* Stats is No_stats or Contention_stats, see stats(). Blocking lists can
+be waited on with pop_front_wait(), next() and open_eventfd(); every push
+on them pays a full fence to find the waiters, the other lists pay
+nothing. */
+template <typename T, Concurrency Mode = Concurrency::MPMC, typename Stats = No_stats, bool Blocking = false>
 struct Lock_free_list {
 
   class iterator;
   class const_iterator;
+
+  static constexpr Concurrency concurrency = Mode;
+
+  /* What an iterator keeps to count its recoveries, nothing without stats */
+  using stats_ref = std::conditional_t<Stats::enabled, Stats*, No_stats>;
+
+  static constexpr bool is_queue = Mode != Concurrency::MPMC;
+
+  static constexpr bool single_consumer = Mode == Concurrency::SPSC || Mode == Concurrency::MPSC;
+
+  static constexpr bool blocking = Blocking;
+
+  /* Guard that times the calling operation, for policies with a
+  time(List_op) such as Latency_stats in latency_stats.h */
+  auto time_op([[maybe_unused]] List_op op) noexcept {
+    if constexpr (requires(Stats& stats) { stats.time(op); }) {
+      return m_stats.time(op);
+    } else {
+      return No_timer{};
+    }
+  }
+
+  /* Contention and linearization hooks, counted by the stats policy and
+  traced by the USDT probes. op is the List_op as an int. */
+  void cas_failed(List_op op) noexcept {
+    m_stats.cas_failure(op);
+    LOCKFREELIST_PROBE(cas_failure, this, static_cast<int>(op));
+  }
+
+  void remove_retried() noexcept {
+    m_stats.remove_retry();
+    LOCKFREELIST_PROBE(retry, this, static_cast<int>(List_op::remove));
+  }
+
+  void tail_lagged() noexcept {
+    m_stats.tail_lag();
+    LOCKFREELIST_PROBE(retry, this, static_cast<int>(List_op::push_back));
+  }
+
+  /* The node became reachable from the head */
+  void inserted([[maybe_unused]] List_op op, [[maybe_unused]] Node* node) noexcept {
+    if constexpr (is_versioned) {
+      static_cast<Versioned_node*>(static_cast<T*>(node))->settle_insert_epoch(m_epoch);
+    }
+    LOCKFREELIST_PROBE(insert, this, node, static_cast<int>(op));
+  }
+
+  /* The node stopped being reachable from the head */
+  void removed([[maybe_unused]] List_op op, [[maybe_unused]] Node* node) noexcept {
+    LOCKFREELIST_PROBE(remove, this, node, static_cast<int>(op));
+  }
+
+  static void count_recovery(stats_ref stats) noexcept {
+    if constexpr (Stats::enabled) {
+      if (stats != nullptr) {
+        stats->iterator_recovery();
+      }
+    }
+  }
     
   struct iterator {
     using value_type = T;
@@ -94,8 +448,8 @@ struct Lock_free_list {
         
     iterator() noexcept : m_node(nullptr) {}
 
-    explicit iterator(Node* node, Node* prev = nullptr) noexcept 
-      : m_node(node), m_prev(prev) {}
+    explicit iterator(Node* node, Node* prev = nullptr, stats_ref stats = {}) noexcept 
+      : m_node(node), m_prev(prev), m_stats(stats) {}
         
     reference operator*() const {
       if (m_node == nullptr) {
@@ -121,6 +475,8 @@ struct Lock_free_list {
             
       /* Verify the node hasn't been removed */
       if ((Node*)m_node->m_prev.load(std::memory_order_acquire) != m_prev) {
+        count_recovery(m_stats);
+
         /* Node was removed, try to recover by finding next valid node */
         while (m_node != nullptr && (Node*)m_node->m_prev.load(std::memory_order_acquire) != m_prev) {
           m_node = (Node*)m_node->m_next.load(std::memory_order_acquire);
@@ -153,6 +509,8 @@ struct Lock_free_list {
             
       /* Verify the node hasn't been removed */
       if (m_prev->m_next.load(std::memory_order_acquire) != m_node) {
+        count_recovery(m_stats);
+
         /* Node was removed, try to recover by finding previous valid node */
         while (m_prev != nullptr && (Node*)m_prev->m_next.load(std::memory_order_acquire) != m_node) {
           m_prev = (Node*)m_prev->m_prev.load(std::memory_order_acquire);
@@ -186,6 +544,8 @@ struct Lock_free_list {
 
     /* Keep track of previous node for bidirectional iteration */
     Node* m_prev;
+
+    [[no_unique_address]] stats_ref m_stats{};
   };
     
   struct const_iterator {
@@ -199,10 +559,10 @@ struct Lock_free_list {
       : m_node(nullptr), m_prev(nullptr) {}
 
     const_iterator(const iterator& other) noexcept 
-      : m_node(other.m_node), m_prev(other.m_prev) {}
+      : m_node(other.m_node), m_prev(other.m_prev), m_stats(other.m_stats) {}
 
-    explicit const_iterator(const Node* node, const Node* prev = nullptr) noexcept 
-      : m_node(node), m_prev(prev) {}
+    explicit const_iterator(const Node* node, const Node* prev = nullptr, stats_ref stats = {}) noexcept 
+      : m_node(node), m_prev(prev), m_stats(stats) {}
         
     reference operator*() const {
       if (m_node == nullptr) {
@@ -226,6 +586,8 @@ struct Lock_free_list {
       auto next = (Node*)m_node->m_next.load(std::memory_order_acquire);
             
       if ((Node*)m_node->m_prev.load(std::memory_order_acquire) != m_prev) {
+        count_recovery(m_stats);
+
         while (m_node != nullptr && (Node*)m_node->m_prev.load(std::memory_order_acquire) != m_prev) {
           m_node = (Node*)m_node->m_next.load(std::memory_order_acquire);
           if (m_node != nullptr) {
@@ -254,6 +616,8 @@ struct Lock_free_list {
       auto prev = (Node*)m_prev->m_prev.load(std::memory_order_acquire);
             
       if ((Node*)m_prev->m_next.load(std::memory_order_acquire) != m_node) {
+        count_recovery(m_stats);
+
         while (m_prev != nullptr && (Node*)m_prev->m_next.load(std::memory_order_acquire) != m_node) {
           m_prev = (Node*)m_prev->m_prev.load(std::memory_order_acquire);
           if (m_prev != nullptr) {
@@ -284,8 +648,225 @@ struct Lock_free_list {
         
     const Node* m_node;
     const Node* m_prev;
+
+    [[no_unique_address]] stats_ref m_stats{};
   };
     
+  /* Forward iterator that keeps a ring of the next Distance nodes. Every node
+  is prefetched when it enters the ring and only dereferenced Distance steps
+  later. A node's address is only known once the node before it has
+  arrived, so the misses along the chain stay serial and at most one is in
+  flight: the ring lets that miss overlap the caller's work on the current
+  node, a longer ring only smooths out uneven work per node and does not
+  add parallel misses. Walks m_next only, without the m_prev checks of the
+  bidirectional iterators, like find_if(). */
+  template <size_t Distance>
+  struct prefetch_iterator {
+    static_assert(Distance > 0, "Prefetch distance must be at least one node");
+
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    prefetch_iterator() noexcept = default;
+
+    explicit prefetch_iterator(Node* node) noexcept {
+      /* Prime the ring with the first Distance nodes */
+      while (node != nullptr && m_size < Distance) {
+        __builtin_prefetch(node, 0, 3);
+        m_ring[m_size++] = node;
+        node = (Node*)node->m_next.load(std::memory_order_acquire);
+      }
+    }
+
+    reference operator*() const {
+      if (m_size == 0) {
+        throw std::runtime_error("Dereferencing null iterator");
+      }
+      return *static_cast<T*>(m_ring[m_pos]);
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    prefetch_iterator& operator++() {
+      if (m_size == 0) {
+        throw std::runtime_error("Incrementing null iterator");
+      }
+
+      /* Extend the ring by one from its last node, then drop the current one.
+      With a full ring the new node goes into the slot being vacated. */
+      const auto last = m_ring[(m_pos + m_size - 1) % Distance];
+
+      if (auto next = (Node*)last->m_next.load(std::memory_order_acquire); next != nullptr) {
+        __builtin_prefetch(next, 0, 3);
+        m_ring[(m_pos + m_size) % Distance] = next;
+        ++m_size;
+      }
+
+      m_pos = (m_pos + 1) % Distance;
+      --m_size;
+
+      return *this;
+    }
+
+    prefetch_iterator operator++(int) {
+      auto tmp = *this;
+
+      ++(*this);
+      return tmp;
+    }
+
+    Node* node() const noexcept {
+      return m_size == 0 ? nullptr : m_ring[m_pos];
+    }
+
+    bool operator==(const prefetch_iterator& rhs) const noexcept {
+      return node() == rhs.node();
+    }
+
+    bool operator!=(const prefetch_iterator& rhs) const noexcept {
+      return !(*this == rhs);
+    }
+
+    std::array<Node*, Distance> m_ring{};
+
+    /* Index of the current node in m_ring */
+    size_t m_pos{};
+
+    /* Number of valid nodes in the ring */
+    size_t m_size{};
+  };
+
+  template <size_t Distance>
+  struct prefetch_range {
+    prefetch_iterator<Distance> begin() const noexcept {
+      return prefetch_iterator<Distance>(m_list->m_head.load(std::memory_order_acquire));
+    }
+
+    prefetch_iterator<Distance> end() const noexcept {
+      return prefetch_iterator<Distance>();
+    }
+
+    Lock_free_list* m_list;
+  };
+
+  static constexpr bool is_versioned = std::is_base_of_v<Versioned_node, T>;
+
+  /* Forward iterator over the nodes visible at a snapshot epoch */
+  struct snapshot_iterator {
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    snapshot_iterator() noexcept = default;
+
+    snapshot_iterator(Node* node, uint64_t epoch, const std::atomic<uint64_t>* list_epoch) noexcept
+      : m_node(node), m_epoch(epoch), m_list_epoch(list_epoch) {
+      skip_invisible();
+    }
+
+    reference operator*() const {
+      if (m_node == nullptr) {
+        throw std::runtime_error("Dereferencing null iterator");
+      }
+      return *static_cast<T*>(m_node);
+    }
+
+    pointer operator->() const {
+      return &**this;
+    }
+
+    snapshot_iterator& operator++() {
+      if (m_node == nullptr) {
+        throw std::runtime_error("Incrementing null iterator");
+      }
+
+      /* Nodes removed after the snapshot are still linked, so m_next is
+      enough, no need for the m_prev recovery of the plain iterator. */
+      m_node = (Node*)m_node->m_next.load(std::memory_order_acquire);
+      skip_invisible();
+
+      return *this;
+    }
+
+    snapshot_iterator operator++(int) {
+      auto tmp = *this;
+
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const snapshot_iterator& rhs) const noexcept {
+      return m_node == rhs.m_node;
+    }
+
+    bool operator!=(const snapshot_iterator& rhs) const noexcept {
+      return !(*this == rhs);
+    }
+
+    void skip_invisible() noexcept {
+      while (m_node != nullptr && !static_cast<Versioned_node*>(static_cast<T*>(m_node))->visible_at(m_epoch, *m_list_epoch)) {
+        m_node = (Node*)m_node->m_next.load(std::memory_order_acquire);
+      }
+    }
+
+    Node* m_node{};
+    uint64_t m_epoch{};
+    const std::atomic<uint64_t>* m_list_epoch{};
+  };
+
+  /* Point in time view of the list. While any snapshot is open remove()
+  only stamps nodes and leaves them linked, the last snapshot to close
+  unlinks them. Writers are never blocked.
+
+  Only snapshots filter: plain iterators and find() walk the linked nodes,
+  and the iterators still return nodes removed under an open snapshot until
+  it closes. pop_front() and detach_all() take nodes off at once without
+  stamping them, a snapshot open at the time can miss them. */
+  struct snapshot {
+    static_assert(is_versioned, "snapshot() needs nodes derived from ut::Versioned_node");
+
+    explicit snapshot(Lock_free_list& list) noexcept
+      : m_list(&list) {
+      /* Publish the reader before taking the epoch, see retire() */
+      m_list->m_snapshots.fetch_add(1, std::memory_order_seq_cst);
+      m_epoch = m_list->m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    snapshot(const snapshot&) = delete;
+    snapshot& operator=(const snapshot&) = delete;
+
+    ~snapshot() {
+      /* A snapshot opened after the count drops takes at least this epoch */
+      const auto floor = m_list->m_epoch.load(std::memory_order_seq_cst);
+
+      if (m_list->m_snapshots.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+        m_list->sweep(floor);
+      }
+    }
+
+    snapshot_iterator begin() const noexcept {
+      return snapshot_iterator(m_list->m_head.load(std::memory_order_acquire), m_epoch, &m_list->m_epoch);
+    }
+
+    snapshot_iterator end() const noexcept {
+      return snapshot_iterator();
+    }
+
+    uint64_t epoch() const noexcept {
+      return m_epoch;
+    }
+
+    Lock_free_list* m_list;
+    uint64_t m_epoch{};
+  };
+
   Lock_free_list() {
     Node::Tag null_tag{}; 
 
@@ -295,17 +876,28 @@ struct Lock_free_list {
 
   ~Lock_free_list() {
     clear();
+#if defined(__linux__)
+    if (auto fd = m_event_fd.load(std::memory_order_relaxed); fd >= 0) {
+      ::close(fd);
+    }
+#endif
   }
 
   /* Add a node to the front */
   void push_front(Node* node) {
+    static_assert(!is_queue, "Queue modes only push_back");
     assert(node != nullptr);
+    [[maybe_unused]] auto timer = time_op(List_op::push_front);
         
     typename Node::Tag null_ptr{};
 
     node->init();
+    stamp_insert(node);
+    m_stats.call(List_op::push_front);
         
     for (;;) {
+      m_stats.attempt(List_op::push_front);
+
       auto old_head = m_head.load(std::memory_order_acquire);
             
       /* Setup new node's pointers */
@@ -315,6 +907,8 @@ struct Lock_free_list {
       typename Node::Tag new_head{node, old_head.version() + 1};
             
       if (m_head.compare_exchange_weak(old_head, new_head, std::memory_order_release, std::memory_order_relaxed)) {
+        inserted(List_op::push_front, node);
+
         if (old_head != nullptr) {
           /* Update old head's prev pointer */
           auto old_prev = ((Node*) old_head)->m_prev.load(std::memory_order_acquire);
@@ -325,35 +919,865 @@ struct Lock_free_list {
           // Empty list case - update tail
           m_tail.store(new_head, std::memory_order_release);
         }
+        wake_waiters();
         return;
       }
+      cas_failed(List_op::push_front);
     }
   }
 
   /* Remove a specific node */
   void remove(Node* node) {
-    for (;;) {
-      /* Load both links with their versions */
-      auto prev = node->m_prev.load(std::memory_order_acquire);
-      auto next = node->m_next.load(std::memory_order_acquire);
-            
-      Node *prev_ptr = prev;
-      Node *next_ptr = next;
-            
-      if (prev_ptr != nullptr) {
-        /* Read prev's current next pointer and version */
-        auto expected = ((Node*)prev)->m_next.load(std::memory_order_acquire);
+    static_assert(!is_queue, "Queue modes only pop_front");
+    [[maybe_unused]] auto timer = time_op(List_op::remove);
 
-        if (expected != node) {
-          /* Node already removed or list changed */
-          continue;
-        }
+    m_stats.call(List_op::remove);
+
+    if constexpr (is_versioned) {
+      auto versioned = static_cast<Versioned_node*>(static_cast<T*>(node));
+
+      if (retire(versioned)) {
+        unlink(node);
+        versioned->m_remove_epoch.fetch_or(Versioned_node::unlinked, std::memory_order_release);
+      }
+    } else {
+      unlink(node);
+    }
+  }
+
+  /* Detach the first node and return it, nullptr if the list is empty. The
+  caller owns the node again. Safe against concurrent push_front, push_back
+  and pop_front, not against remove() of the same node. */
+  Node* pop_front() {
+    [[maybe_unused]] auto timer = time_op(List_op::pop_front);
+    m_stats.call(List_op::pop_front);
+
+    if constexpr (is_queue) {
+      return dequeue();
+    }
+
+    for (;;) {
+      m_stats.attempt(List_op::pop_front);
+
+      auto old_head = m_head.load(std::memory_order_acquire);
+      Node* node = old_head;
+
+      if (node == nullptr) {
+        return nullptr;
+      }
+
+      auto next = node->m_next.load(std::memory_order_acquire);
+
+      if (next != nullptr) {
+        if (m_head.compare_exchange_weak(old_head, old_head.next_version().with_ptr(next), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+          removed(List_op::pop_front, node);
+
+          auto next_prev = ((Node*)next)->m_prev.load(std::memory_order_acquire);
+
+          ((Node*)next)->m_prev.compare_exchange_strong(next_prev, typename Node::Tag{nullptr, next_prev.version() + 1}, std::memory_order_release, std::memory_order_relaxed);
+          return node;
+        }
+        cas_failed(List_op::pop_front);
+        continue;
+      }
+
+      /* Last node, unless push_back linked one but has not moved the tail
+      yet. Then move the tail on for it, a lagging tail that nobody moves
+      would keep us from ever taking the node. */
+      auto old_tail = m_tail.load(std::memory_order_acquire);
+
+      if (old_tail == node) {
+        if (take_all(old_head, old_tail)) {
+          removed(List_op::pop_front, node);
+
+          return node;
+        }
+        cas_failed(List_op::pop_front);
+      } else if (old_tail != nullptr) {
+        advance_tail(old_tail);
+      }
+    }
+  }
+
+  /* Detach every node and return the first and last of the chain, which
+  stays linked through m_next and m_prev. Both are nullptr if the list was
+  empty. Same concurrency guarantees as pop_front(). */
+  std::pair<Node*, Node*> detach_all() {
+    static_assert(!is_queue, "Not in queue modes");
+
+    for (;;) {
+      auto old_head = m_head.load(std::memory_order_acquire);
+
+      if (old_head == nullptr) {
+        return {nullptr, nullptr};
+      }
+
+      /* A null tail under a non null head is a pop or detach in progress.
+      take_all() moves a lagging tail on when it fails on it. */
+      auto old_tail = m_tail.load(std::memory_order_acquire);
+
+      if (old_tail != nullptr && take_all(old_head, old_tail)) {
+        return {old_head, old_tail};
+      }
+    }
+  }
+
+  /* Detach the back half of the nodes, rounded up, and return the first and
+  last of that chain, linked through m_next. The front half stays where it
+  is, for lists whose owner works at the front while others take from the
+  back. The walk to the middle checks the head after every step, so a node
+  popped meanwhile is never followed. The tail is taken and sealed as in
+  take_all(), the chain is cut after the front half and last the head's
+  version is bumped: a pop_front() that read a node before the cut fails
+  its CAS, and if one got in first the cut is undone. Same concurrency
+  guarantees as pop_front(). */
+  std::pair<Node*, Node*> detach_back_half() {
+    static_assert(!is_queue, "Not in queue modes");
+
+    for (;;) {
+      auto old_head = m_head.load(std::memory_order_acquire);
+
+      if (old_head == nullptr) {
+        return {nullptr, nullptr};
+      }
+
+      auto old_tail = m_tail.load(std::memory_order_acquire);
+
+      if (old_tail == nullptr) {
+        /* A pop or detach in progress */
+        cpu_relax();
+        continue;
+      }
+
+      if (advance_tail(old_tail)) {
+        continue;
+      }
+
+      /* keep_last trails at the last node of the front half, n / 2 nodes */
+      auto last = (Node*)old_tail;
+      Node* node = old_head;
+      Node* keep_last = old_head;
+      size_t n{1};
+
+      while (node != last) {
+        node = node->m_next.load(std::memory_order_acquire);
+
+        Node* keep_next = ++n % 2 == 0 && n > 2 ? (Node*)keep_last->m_next.load(std::memory_order_acquire) : keep_last;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (m_head.load(std::memory_order_relaxed) != old_head || node == nullptr) {
+          break;
+        }
+        keep_last = keep_next;
+      }
+
+      if (node != last) {
+        continue;
+      }
+
+      if (n == 1) {
+        if (take_all(old_head, old_tail)) {
+          return {old_head, old_tail};
+        }
+        continue;
+      }
+
+      const typename Node::Tag null_tail{nullptr, old_tail.version() + 1};
+      const typename Node::Tag back_tail{last, null_tail.version() + 1};
+
+      if (!m_tail.compare_exchange_strong(old_tail, null_tail, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        continue;
+      }
+
+      auto next = last->m_next.load(std::memory_order_acquire);
+
+      if (next != nullptr || !last->m_next.compare_exchange_strong(next, next.next_version(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+        /* A push_back got in first, its tail update failed against ours */
+        m_tail.store(typename Node::Tag{next, null_tail.version() + 1}, std::memory_order_release);
+        continue;
+      }
+
+      auto cut = keep_last->m_next.load(std::memory_order_acquire);
+      Node* first = cut;
+
+      if (first == nullptr || !keep_last->m_next.compare_exchange_strong(cut, cut.next_version().with_ptr(nullptr), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        m_tail.store(back_tail, std::memory_order_release);
+        continue;
+      }
+
+      if (!m_head.compare_exchange_strong(old_head, old_head.next_version(), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        /* A pop or push at the front got in, put the chain back */
+        keep_last->m_next.store(cut.next_version().next_version(), std::memory_order_release);
+        m_tail.store(back_tail, std::memory_order_release);
+        continue;
+      }
+
+      m_tail.store(typename Node::Tag{keep_last, null_tail.version() + 1}, std::memory_order_release);
+      return {first, last};
+    }
+  }
+
+  /* Link the chain first..last, owned by the caller, in front of the list */
+  void splice_front(Node* first, Node* last) {
+    static_assert(!is_queue, "Queue modes only push_back");
+    assert(first != nullptr && last != nullptr);
+
+    first->m_prev.store(typename Node::Tag{nullptr, first->m_prev.load(std::memory_order_relaxed).version() + 1}, std::memory_order_relaxed);
+
+    for (;;) {
+      auto old_head = m_head.load(std::memory_order_acquire);
+
+      last->m_next.store(typename Node::Tag{old_head, last->m_next.load(std::memory_order_relaxed).version() + 1}, std::memory_order_relaxed);
+
+      if (m_head.compare_exchange_weak(old_head, old_head.next_version().with_ptr(first), std::memory_order_release, std::memory_order_relaxed)) {
+        if (old_head != nullptr) {
+          auto old_prev = ((Node*)old_head)->m_prev.load(std::memory_order_acquire);
+
+          ((Node*)old_head)->m_prev.store(typename Node::Tag{last, old_prev.version() + 1}, std::memory_order_release);
+        } else {
+          m_tail.store(typename Node::Tag{last, m_tail.load(std::memory_order_relaxed).version() + 1}, std::memory_order_release);
+        }
+        wake_waiters();
+        return;
+      }
+    }
+  }
+
+  /* Empty the list if it still runs from old_head to old_tail. The tail is
+  taken first so that push_back stops using it, then the version of its
+  null next link is bumped so that a push_back that read the tail before we
+  took it fails its CAS, and last the head is swung to null. Any step
+  failing puts the tail back and returns false. */
+  bool take_all(typename Node::Tag old_head, typename Node::Tag old_tail) {
+    const typename Node::Tag null_tail{nullptr, old_tail.version() + 1};
+
+    if (!m_tail.compare_exchange_strong(old_tail, null_tail, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return false;
+    }
+
+    auto last = (Node*)old_tail;
+    auto next = last->m_next.load(std::memory_order_acquire);
+
+    if (next != nullptr || !last->m_next.compare_exchange_strong(next, next.next_version(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+      /* A push_back got in first, its tail update failed against ours */
+      m_tail.store(typename Node::Tag{next, null_tail.version() + 1}, std::memory_order_release);
+      return false;
+    }
+
+    if (m_head.compare_exchange_strong(old_head, old_head.next_version().with_ptr(nullptr), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return true;
+    }
+
+    /* A push_front or pop_front moved the head, the tail is still ours */
+    m_tail.store(typename Node::Tag{last, null_tail.version() + 1}, std::memory_order_release);
+    return false;
+  }
+
+  /* push_back links a node before it moves the tail and insert_after only
+  moves a tail it finds on its node, so the tail can lag behind the last
+  node. Move it one node on if old_tail has a successor, returns false if
+  it has none. Every operation that waits for the tail helps like this. */
+  bool advance_tail(typename Node::Tag old_tail) {
+    auto next = ((Node*)old_tail)->m_next.load(std::memory_order_acquire);
+
+    if (next == nullptr) {
+      return false;
+    }
+
+    tail_lagged();
+    m_tail.compare_exchange_strong(old_tail, typename Node::Tag{next, old_tail.version() + 1}, std::memory_order_release, std::memory_order_relaxed);
+    return true;
+  }
+
+  /* Unlink node, the last node, whose predecessor is prev or nullptr if it
+  is also the first. Like take_all() the tail is taken first and the
+  version of the node's null next link bumped, so no push_back can link
+  behind the node, then prev drops it and the tail moves back to prev.
+  Returns false, with the tail put back, if the list changed under us. */
+  bool unlink_tail(Node* node, Node* prev) {
+    auto old_tail = m_tail.load(std::memory_order_acquire);
+
+    if (old_tail != node) {
+      if (old_tail != nullptr) {
+        advance_tail(old_tail);
+      }
+      return false;
+    }
+
+    if (prev == nullptr) {
+      auto old_head = m_head.load(std::memory_order_acquire);
+
+      return old_head == node && take_all(old_head, old_tail);
+    }
+
+    const typename Node::Tag null_tail{nullptr, old_tail.version() + 1};
+
+    if (!m_tail.compare_exchange_strong(old_tail, null_tail, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return false;
+    }
+
+    auto next = node->m_next.load(std::memory_order_acquire);
+
+    if (next != nullptr || !node->m_next.compare_exchange_strong(next, next.next_version(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+      /* A push_back got in first, the node is no longer the last */
+      m_tail.store(typename Node::Tag{next, null_tail.version() + 1}, std::memory_order_release);
+      return false;
+    }
+
+    auto expected = prev->m_next.load(std::memory_order_acquire);
+
+    if (expected != node || !prev->m_next.compare_exchange_strong(expected, typename Node::Tag{nullptr, expected.version() + 1}, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      m_tail.store(typename Node::Tag{node, null_tail.version() + 1}, std::memory_order_release);
+      return false;
+    }
+
+    m_tail.store(typename Node::Tag{prev, null_tail.version() + 1}, std::memory_order_release);
+    return true;
+  }
+
+  /* Append in a queue mode. Between the exchange and the link the node is
+  not reachable from the head, a consumer that finds the old tail without
+  a successor waits for the link. */
+  void enqueue(Node* node) {
+    const auto prev = m_tail.exchange(typename Node::Tag{node, 0}, std::memory_order_acq_rel);
+
+    inserted(List_op::push_back, node);
+
+    if (prev == nullptr) {
+      /* The queue was empty, consumers leave the head to us */
+      m_head.store(m_head.load(std::memory_order_relaxed).next_version().with_ptr(node), std::memory_order_release);
+    } else {
+      ((Node*)prev)->m_next.store(typename Node::Tag{node, 0}, std::memory_order_release);
+    }
+  }
+
+  /* Take the first node in a queue mode. The head is claimed first, with a
+  plain store when there is one consumer and a CAS otherwise. Only the last
+  node touches the tail: if a producer swapped the tail before we could
+  null it, its link to the node is on the way and becomes the new head. */
+  Node* dequeue() {
+    for (;;) {
+      m_stats.attempt(List_op::pop_front);
+
+      auto old_head = m_head.load(std::memory_order_acquire);
+      Node* node = old_head;
+
+      if (node == nullptr) {
+        return nullptr;
+      }
+
+      Node* next = node->m_next.load(std::memory_order_acquire);
+
+      if constexpr (single_consumer) {
+        m_head.store(old_head.next_version().with_ptr(next), std::memory_order_relaxed);
+      } else if (!m_head.compare_exchange_weak(old_head, old_head.next_version().with_ptr(next), std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        cas_failed(List_op::pop_front);
+        continue;
+      }
+
+      removed(List_op::pop_front, node);
+
+      if (next != nullptr) {
+        return node;
+      }
+
+      /* The node is ours and the head is null, producers write the head
+      only after finding the tail null */
+      typename Node::Tag expected{node, 0};
+
+      if (m_tail.compare_exchange_strong(expected, typename Node::Tag{}, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        return node;
+      }
+
+      while ((next = node->m_next.load(std::memory_order_acquire)) == nullptr) {
+        cpu_relax();
+      }
+
+      m_head.store(m_head.load(std::memory_order_relaxed).next_version().with_ptr(next), std::memory_order_release);
+
+      /* The producer linked next while the head was null, a waiter may
+      have missed it */
+      wake_waiters();
+      return node;
+    }
+  }
+
+  /* Single consumer queue modes: take up to max_batch nodes from the front
+  and call fn(T&) on each, oldest first. The head is written once for the
+  whole batch. fn may free or push the node again. Returns the number of
+  nodes drained. */
+  template <typename Fn>
+  size_t drain(Fn fn, size_t max_batch = SIZE_MAX) {
+    static_assert(is_queue && single_consumer, "drain() needs a single consumer queue mode");
+
+    size_t n{};
+    Node* node = m_head.load(std::memory_order_acquire);
+
+    if (node == nullptr) {
+      /* Empty, the next producer writes the head */
+      return 0;
+    }
+
+    while (n < max_batch) {
+      Node* next = node->m_next.load(std::memory_order_acquire);
+
+      if (next == nullptr) {
+        /* Last node, same hand over as in dequeue() */
+        m_head.store(m_head.load(std::memory_order_relaxed).next_version().with_ptr(nullptr), std::memory_order_relaxed);
+
+        typename Node::Tag expected{node, 0};
+
+        if (!m_tail.compare_exchange_strong(expected, typename Node::Tag{}, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+          while ((next = node->m_next.load(std::memory_order_acquire)) == nullptr) {
+            cpu_relax();
+          }
+        }
+
+        removed(List_op::pop_front, node);
+        fn(*static_cast<T*>(node));
+        ++n;
+
+        if (next == nullptr) {
+          /* The queue is empty and the head belongs to the producers */
+          return n;
+        }
+      } else {
+        removed(List_op::pop_front, node);
+        fn(*static_cast<T*>(node));
+        ++n;
+      }
+
+      node = next;
+    }
+
+    m_head.store(m_head.load(std::memory_order_relaxed).next_version().with_ptr(node), std::memory_order_release);
+    return n;
+  }
+
+  /* pop_front(), but if the list is empty park on a futex until a push or
+  the timeout. Returns nullptr on timeout. The waiter registers in
+  m_waiters and then checks the list again, a pusher checks m_waiters after
+  linking its node, with a full fence on both sides one of them sees the
+  other. Pushes with nobody waiting skip the syscall. */
+  Node* pop_front_wait(std::chrono::nanoseconds timeout) {
+    static_assert(blocking, "pop_front_wait() needs a Blocking_list");
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (;;) {
+      if (auto node = pop_front()) {
+        return node;
+      }
+
+      const auto seq = m_wake_seq.load(std::memory_order_acquire);
+
+      m_waiters.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      auto node = pop_front();
+
+      if (node == nullptr) {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (now < deadline) {
+          futex_wait(m_wake_seq, seq, deadline - now);
+        }
+      }
+
+      m_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+      if (node != nullptr) {
+        return node;
+      }
+
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return pop_front();
+      }
+    }
+  }
+
+  /* Called after a push made the list non empty, a no-op unless blocking */
+  void wake_waiters() {
+    if constexpr (blocking) {
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (m_waiters.load(std::memory_order_relaxed) != 0) {
+        m_wake_seq.fetch_add(1, std::memory_order_release);
+        futex_wake(m_wake_seq);
+      }
+
+      if (m_awaiters.load(std::memory_order_relaxed) != nullptr) {
+        resume_awaiters();
+      }
+
+#if defined(__linux__)
+      if (m_event_fd.load(std::memory_order_relaxed) >= 0
+          && !m_event_pending.load(std::memory_order_relaxed)
+          && !m_event_pending.exchange(true, std::memory_order_relaxed)) {
+        signal_eventfd();
+      }
+#endif
+    }
+  }
+
+#if defined(__linux__)
+  /* Attach an eventfd that becomes readable when the list goes from empty
+  to non empty, for consumers that sit in epoll. Signals are coalesced: the
+  first push signals and later pushes skip the write until the consumer
+  has emptied the list and called rearm_eventfd(). The fd stays readable
+  in between, so a consumer may go back to epoll after a partial batch. The
+  list owns the fd. Returns -1 and sets errno if it could not be created. */
+  int open_eventfd() {
+    static_assert(blocking, "open_eventfd() needs a Blocking_list");
+    assert(m_event_fd.load(std::memory_order_relaxed) < 0);
+
+    const int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (fd < 0) {
+      return -1;
+    }
+
+    m_event_fd.store(fd, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    /* Nodes pushed before the fd was attached */
+    if (m_head.load(std::memory_order_acquire) != nullptr && !m_event_pending.exchange(true, std::memory_order_relaxed)) {
+      signal_eventfd();
+    }
+    return fd;
+  }
+
+  int event_fd() const noexcept {
+    return m_event_fd.load(std::memory_order_acquire);
+  }
+
+  /* Call once the list looks empty. Clears the fd and lets the next push
+  signal again. Returns false if nodes arrived without a signal, the caller
+  must then keep draining and call this again. */
+  bool rearm_eventfd() {
+    uint64_t count;
+
+    while (::read(m_event_fd.load(std::memory_order_relaxed), &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+
+    m_event_pending.store(false, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    /* A push may have seen the flag still set before we cleared it. If
+    another push signalled meanwhile epoll will report it. */
+    return m_head.load(std::memory_order_acquire) == nullptr || m_event_pending.exchange(true, std::memory_order_relaxed);
+  }
+
+  void signal_eventfd() noexcept {
+    const uint64_t one = 1;
+
+    while (::write(m_event_fd.load(std::memory_order_relaxed), &one, sizeof(one)) < 0 && errno == EINTR) {
+    }
+  }
+#endif
+
+  /* Awaitable returned by next(), resumes with the popped node */
+  template <typename Executor>
+  struct next_awaiter : List_waiter {
+    next_awaiter(Lock_free_list& list, Executor executor)
+      : m_list(list), m_executor(std::move(executor)) {}
+
+    bool await_ready() {
+      m_node = m_list.pop_front();
+      return m_node != nullptr;
+    }
+
+    /* The coroutine may be resumed, and this destroyed, before park()
+    returns */
+    void await_suspend(std::coroutine_handle<> handle) {
+      m_handle = handle;
+
+      if constexpr (std::is_same_v<Executor, Queue_executor>) {
+        m_wake = [](List_waiter* waiter) {
+          static_cast<next_awaiter*>(waiter)->m_list.queue_woken(waiter);
+        };
+      } else {
+        m_wake = [](List_waiter* waiter) {
+          auto self = static_cast<next_awaiter*>(waiter);
+          auto executor = self->m_executor;
+
+          executor(self->m_handle);
+        };
+      }
+      m_list.park(this);
+    }
+
+    T* await_resume() const noexcept {
+      return static_cast<T*>(m_node);
+    }
+
+    Lock_free_list& m_list;
+    [[no_unique_address]] Executor m_executor;
+  };
+
+  /* co_await list.next(executor) suspends until a node can be popped and
+  returns it, the coroutine is resumed through executor(handle). The node
+  is popped by the pusher that wakes the coroutine, so it never resumes to
+  an empty list. By default the coroutine is queued on the list until a
+  consumer thread calls resume_woken(), pass Inline_executor to run it
+  inside the push instead. Pushers pop for the waiters, so single consumer
+  modes, whose pop_front() allows one popping thread, cannot use it. */
+  template <typename Executor = Queue_executor>
+  next_awaiter<Executor> next(Executor executor = Executor{}) {
+    static_assert(blocking, "next() needs a Blocking_list");
+    static_assert(!single_consumer, "next() pops on the pushing threads, single consumer modes cannot");
+    return next_awaiter<Executor>(*this, std::move(executor));
+  }
+
+  /* Resume the coroutines next() queued on the list, in the order they were
+  woken. Returns how many were resumed. */
+  size_t resume_woken() {
+    auto waiter = m_woken.exchange(nullptr, std::memory_order_acquire);
+    List_waiter* oldest{};
+
+    while (waiter != nullptr) {
+      auto next = waiter->m_next;
+
+      waiter->m_next = oldest;
+      oldest = waiter;
+      waiter = next;
+    }
+
+    size_t n{};
+
+    /* The waiter is gone once resumed */
+    while (oldest != nullptr) {
+      auto next = oldest->m_next;
+
+      oldest->m_handle.resume();
+      oldest = next;
+      ++n;
+    }
+    return n;
+  }
+
+  /* Push a woken waiter for resume_woken(). Like the waiter stack it is
+  only ever emptied whole, so it has no ABA. */
+  void queue_woken(List_waiter* waiter) noexcept {
+    auto top = m_woken.load(std::memory_order_relaxed);
+
+    do {
+      waiter->m_next = top;
+    } while (!m_woken.compare_exchange_weak(top, waiter, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  /* Push a waiter on the waiter stack. Like pop_front_wait() the list is
+  checked again after the full fence, a pusher that missed the waiter has
+  made the list non empty and we pop for it ourselves. */
+  void park(List_waiter* waiter) {
+    auto top = m_awaiters.load(std::memory_order_relaxed);
+
+    do {
+      waiter->m_next = top;
+    } while (!m_awaiters.compare_exchange_weak(top, waiter, std::memory_order_release, std::memory_order_relaxed));
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (m_head.load(std::memory_order_acquire) != nullptr) {
+      resume_awaiters();
+    }
+  }
+
+  /* Take the whole waiter stack and pop a node for each waiter. Taking the
+  stack with an exchange means no waiter is ever popped singly, so the
+  stack has no ABA. Waiters left over when the list runs dry are parked
+  again, and the list checked again for pushes that found the stack empty
+  while we held it. */
+  void resume_awaiters() {
+    for (;;) {
+      auto waiter = m_awaiters.exchange(nullptr, std::memory_order_acquire);
+
+      while (waiter != nullptr) {
+        auto node = pop_front();
+
+        if (node == nullptr) {
+          break;
+        }
+
+        /* The waiter is gone once woken */
+        auto next = waiter->m_next;
+
+        waiter->m_node = node;
+        waiter->m_wake(waiter);
+        waiter = next;
+      }
+
+      if (waiter == nullptr) {
+        return;
+      }
+
+      auto last = waiter;
+
+      while (last->m_next != nullptr) {
+        last = last->m_next;
+      }
+
+      auto top = m_awaiters.load(std::memory_order_relaxed);
+
+      do {
+        last->m_next = top;
+      } while (!m_awaiters.compare_exchange_weak(top, waiter, std::memory_order_release, std::memory_order_relaxed));
+
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (m_head.load(std::memory_order_acquire) == nullptr) {
+        return;
+      }
+    }
+  }
+
+  /* Sleep while word == expected, at most timeout. Spurious returns are fine */
+  static void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout) noexcept {
+#if defined(__linux__)
+    const auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    const timespec ts{static_cast<time_t>(secs.count()), static_cast<long>((timeout - secs).count())};
+
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+#else
+    /* No timed wait on std::atomic, poll */
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+    while (word.load(std::memory_order_acquire) == expected && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+#endif
+  }
+
+  static void futex_wake(std::atomic<uint32_t>& word) noexcept {
+#if defined(__linux__)
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+  }
+
+  static void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  /* Take a point in time view, iterate it with a range for */
+  snapshot take_snapshot() noexcept {
+    return snapshot(*this);
+  }
+
+  /* Number of open snapshots */
+  uint32_t snapshots_active() const noexcept {
+    return m_snapshots.load(std::memory_order_acquire);
+  }
+
+  /* Mark a node as being inserted, inserted() settles its epoch once the
+  node is linked */
+  void stamp_insert(Node* node) noexcept {
+    if constexpr (is_versioned) {
+      auto versioned = static_cast<Versioned_node*>(static_cast<T*>(node));
+
+      versioned->m_insert_epoch.store(Versioned_node::pending, std::memory_order_relaxed);
+      versioned->m_remove_epoch.store(Versioned_node::live, std::memory_order_relaxed);
+    }
+  }
+
+  /* Stamp a node as removed at the current epoch. Returns true if the caller
+  has to unlink it now, false if an open snapshot may still need to see it.
+  The snapshot takes the epoch after bumping m_snapshots and we check
+  m_snapshots after stamping, so a snapshot whose epoch is older than the
+  stamp is always seen here. */
+  bool retire(Versioned_node* node) noexcept {
+    /* Counted before the stamp, a sweep that can claim the node sees it */
+    m_retired.fetch_add(1, std::memory_order_seq_cst);
+    node->m_remove_epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+
+    /* If the last snapshot closed after we stamped, its sweep may have run
+    past the node already, whoever claims it first unlinks it. */
+    if (m_snapshots.load(std::memory_order_seq_cst) == 0 && node->claim_unlink()) {
+      m_retired.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    return false;
+  }
+
+  /* Number of nodes removed under a snapshot and not unlinked yet */
+  uint32_t retired_pending() const noexcept {
+    return m_retired.load(std::memory_order_acquire);
+  }
+
+  /* Unlink the nodes removed while snapshots were open. Called by the last
+  snapshot to close with the epoch it read before dropping the count. Any
+  snapshot open by now was opened later and has an epoch at or past floor,
+  so only nodes removed at or before floor are unlinked, the rest are left
+  to the sweep after it. Nothing to walk for if no node is waiting: a
+  remove() that left its node linked counted it before it checked for
+  snapshots, so the count is seen after the last one dropped. */
+  void sweep(uint64_t floor) {
+    if (m_retired.load(std::memory_order_seq_cst) == 0) {
+      return;
+    }
+
+    auto current = (Node*)m_head.load(std::memory_order_acquire);
+
+    while (current != nullptr) {
+      auto next = (Node*)current->m_next.load(std::memory_order_acquire);
+      auto versioned = static_cast<Versioned_node*>(static_cast<T*>(current));
+      const auto removed = versioned->m_remove_epoch.load(std::memory_order_acquire);
+
+      if ((removed & Versioned_node::epoch_mask) <= floor && versioned->claim_unlink()) {
+        m_retired.fetch_sub(1, std::memory_order_relaxed);
+        unlink(current);
+        versioned->m_remove_epoch.fetch_or(Versioned_node::unlinked, std::memory_order_release);
+      }
+
+      current = next;
+    }
+  }
+
+  /* Physically unlink a node */
+  void unlink(Node* node) {
+    for (;;) {
+      m_stats.attempt(List_op::remove);
+
+      /* Load both links with their versions */
+      auto prev = node->m_prev.load(std::memory_order_acquire);
+      auto next = node->m_next.load(std::memory_order_acquire);
+            
+      Node *prev_ptr = prev;
+      Node *next_ptr = next;
+
+      if (next_ptr == nullptr) {
+        /* The last node, the tail has to move back with it */
+        if (unlink_tail(node, prev_ptr)) {
+          removed(List_op::remove, node);
+          return;
+        }
+        remove_retried();
+        continue;
+      }
+            
+      if (prev_ptr != nullptr) {
+        /* Read prev's current next pointer and version */
+        auto expected = ((Node*)prev)->m_next.load(std::memory_order_acquire);
+
+        if (expected != node) {
+          /* Node already removed or list changed */
+          remove_retried();
+          continue;
+        }
                 
         /* Prepare new tagged pointer with incremented version */
         Node::Tag new_tag{next_ptr, expected.version() + 1};
                 
         /* Try to update with new version */
         if (((Node*)prev)->m_next.compare_exchange_strong(expected, new_tag, std::memory_order_release, std::memory_order_relaxed)) {
+          removed(List_op::remove, node);
+
           /* Successfully unlinked from prev side */
           if (next != nullptr) {
             auto next_expected = ((Node*)next)->m_prev.load(std::memory_order_acquire);
@@ -364,17 +1788,21 @@ struct Lock_free_list {
           }
           return;
         }
+        cas_failed(List_op::remove);
       } else {
         /* Handle head case */
         auto expected = m_head.load(std::memory_order_acquire);
 
         if (expected != node) {
+          remove_retried();
           continue;
         }
                 
         Node::Tag new_tag{next_ptr, expected.version() + 1};
                 
         if (m_head.compare_exchange_strong(expected, new_tag, std::memory_order_release, std::memory_order_relaxed)) {
+          removed(List_op::remove, node);
+
           if (next_ptr != nullptr) {
             auto next_expected = ((Node*)next)->m_prev.load(std::memory_order_acquire);
             Node::Tag next_new{nullptr, next_expected.version() + 1};
@@ -383,6 +1811,7 @@ struct Lock_free_list {
           }
           return;
         }
+        cas_failed(List_op::remove);
       }
     }
   }
@@ -390,12 +1819,24 @@ struct Lock_free_list {
   /* Add a node to the back */
   void push_back(Node* node) {
     assert(node != nullptr);
+    [[maybe_unused]] auto timer = time_op(List_op::push_back);
 
     node->init();
+    stamp_insert(node);
+    m_stats.call(List_op::push_back);
+
+    if constexpr (is_queue) {
+      m_stats.attempt(List_op::push_back);
+      enqueue(node);
+      wake_waiters();
+      return;
+    }
 
     typename Node::Tag null_tag{};
         
     for (;;) {
+      m_stats.attempt(List_op::push_back);
+
       auto old_tail = m_tail.load(std::memory_order_acquire);
             
       if (old_tail == nullptr) {
@@ -406,9 +1847,13 @@ struct Lock_free_list {
           typename Node::Tag new_tag{node, old_head.version() + 1};
 
           if (m_head.compare_exchange_weak(old_head, new_tag, std::memory_order_release, std::memory_order_relaxed)) {
+            inserted(List_op::push_back, node);
+
             m_tail.store(new_tag, std::memory_order_release);
+            wake_waiters();
             return;
           }
+          cas_failed(List_op::push_back);
         }
         continue;
       }
@@ -419,8 +1864,10 @@ struct Lock_free_list {
       /* Try to update old tail's next pointer */
       auto old_next = ((Node*)old_tail)->m_next.load(std::memory_order_acquire);
 
-      /* Tail was incorrect */
+      /* The tail lags behind a node another push_back linked, move it on */
       if (old_next != nullptr) {
+        tail_lagged();
+        m_tail.compare_exchange_strong(old_tail, typename Node::Tag{old_next, old_tail.version() + 1}, std::memory_order_release, std::memory_order_relaxed);
         continue;
       }
             
@@ -428,25 +1875,35 @@ struct Lock_free_list {
       typename Node::Tag new_next{node, old_next.version() + 1};
 
       if (((Node*)old_tail)->m_next.compare_exchange_weak(old_next, new_next, std::memory_order_release, std::memory_order_relaxed)) {
+        inserted(List_op::push_back, node);
+
         /* Update tail pointer */
         typename Node::Tag new_tail{node, old_tail.version() + 1};
 
         m_tail.compare_exchange_strong(old_tail, new_tail, std::memory_order_release, std::memory_order_relaxed);
+        wake_waiters();
         return;
       }
+      cas_failed(List_op::push_back);
     }    
   }
 
   /* Insert a node after a specific node */
   bool insert_after(Node* node, Node* new_node) {
+    static_assert(!is_queue, "Queue modes only push_back");
+    [[maybe_unused]] auto timer = time_op(List_op::insert_after);
     assert(node != nullptr);
     assert(new_node != nullptr);
         
     typename Node::Tag null_ptr{};
 
     new_node->init();
+    stamp_insert(new_node);
+    m_stats.call(List_op::insert_after);
         
     for (;;) {
+      m_stats.attempt(List_op::insert_after);
+
       auto next_tagged = node->m_next.load(std::memory_order_acquire);
 
       new_node->m_prev.store(typename Node::Tag{node, 0}, std::memory_order_relaxed);
@@ -455,6 +1912,8 @@ struct Lock_free_list {
       typename Node::Tag new_next{new_node, next_tagged.version() + 1};
 
       if (node->m_next.compare_exchange_weak(next_tagged, new_next, std::memory_order_release, std::memory_order_relaxed)) {
+        inserted(List_op::insert_after, new_node);
+
         if (next_tagged != nullptr) {
           auto next_prev = ((Node*)next_tagged)->m_prev.load(std::memory_order_acquire);
           typename Node::Tag new_prev{new_node, next_prev.version() + 1};
@@ -472,16 +1931,30 @@ struct Lock_free_list {
         }
         return true;
       }
+      cas_failed(List_op::insert_after);
     }
   }
 
   /* Find a node with a specific value */
   template<typename Predicate>
   Node* find_if(Predicate pred) {
+    [[maybe_unused]] auto timer = time_op(List_op::find_if);
+    m_stats.call(List_op::find_if);
+
     for (;;) {
+      m_stats.attempt(List_op::find_if);
+
       auto current = m_head.load(std::memory_order_acquire);
         
       while (current != nullptr) {
+        /* Nodes removed under an open snapshot stay linked, skip them */
+        if constexpr (is_versioned) {
+          if (static_cast<Versioned_node*>(static_cast<T*>((Node*)current))->is_removed()) {
+            current = ((Node*)current)->m_next.load(std::memory_order_acquire);
+            continue;
+          }
+        }
+
         /* Check if current node matches predicate */
         if (pred(static_cast<T*>((Node*)current))) {
           /* Verify node is still in list by checking its links */
@@ -490,22 +1963,22 @@ struct Lock_free_list {
                 
           /* If node's next->prev points back to node, it's still valid */
           if (next != nullptr) {
-            if (((Node*)next)->m_prev.load(std::memory_order_acquire) != current) {
+            if ((Node*)((Node*)next)->m_prev.load(std::memory_order_acquire) != (Node*)current) {
               /* Node was removed, restart search */
               break;
             }
-          } else if (m_tail.load(std::memory_order_acquire) != current) {
+          } else if ((Node*)m_tail.load(std::memory_order_acquire) != (Node*)current) {
             /* Node was tail but no longer is */
             break;
           }
                 
           /* If node's prev->next points to node, it's still valid */
           if (prev != nullptr) {
-            if (((Node*)prev)->m_next.load(std::memory_order_acquire) != current) {
+            if ((Node*)((Node*)prev)->m_next.load(std::memory_order_acquire) != (Node*)current) {
               /* Node was removed, restart search */
               break;
             }
-          } else if (m_head.load(std::memory_order_acquire) != current) {
+          } else if ((Node*)m_head.load(std::memory_order_acquire) != (Node*)current) {
             /* Node was head but no longer is */
             break;
           }
@@ -524,8 +1997,9 @@ struct Lock_free_list {
     }
   }
 
-  /* Convenience method to find by value */
-  Node* find(const typename T::value_type& value) {
+  /* Convenience method to find by value, for node types with a value_type */
+  template <typename U = T>
+  Node* find(const typename U::value_type& value) {
     return find_if([&value](const T* node) {
       return node->m_value == value;
     });
@@ -538,32 +2012,63 @@ struct Lock_free_list {
     /* The containing node should be deleted by the list owne*/
     m_head.store(null_tag, std::memory_order_relaxed);
     m_tail.store(null_tag, std::memory_order_relaxed);
+    m_retired.store(0, std::memory_order_relaxed);
   }
 
+  /* The bidirectional iterators check m_prev, which queue modes never write */
   iterator begin() noexcept {
-    return iterator(m_head.load(std::memory_order_acquire), nullptr);
+    static_assert(!is_queue, "Queue modes link m_next only, walk them with prefetched()");
+    return iterator(m_head.load(std::memory_order_acquire), nullptr, stats_of());
   }
     
   const_iterator begin() const noexcept {
-    return const_iterator(m_head.load(std::memory_order_acquire), nullptr);
+    static_assert(!is_queue, "Queue modes link m_next only, walk them with prefetched()");
+    return const_iterator(m_head.load(std::memory_order_acquire), nullptr, stats_of());
   }
     
   const_iterator cbegin() const noexcept {
-    return const_iterator(m_head.load(std::memory_order_acquire), nullptr);
+    static_assert(!is_queue, "Queue modes link m_next only, walk them with prefetched()");
+    return const_iterator(m_head.load(std::memory_order_acquire), nullptr, stats_of());
   }
   
   iterator end() noexcept {
-    return iterator(nullptr, m_tail.load(std::memory_order_acquire));
+    static_assert(!is_queue, "Queue modes link m_next only, walk them with prefetched()");
+    return iterator(nullptr, m_tail.load(std::memory_order_acquire), stats_of());
   }
   
   const_iterator end() const noexcept {
-    return const_iterator(nullptr, m_tail.load(std::memory_order_acquire));
+    static_assert(!is_queue, "Queue modes link m_next only, walk them with prefetched()");
+    return const_iterator(nullptr, m_tail.load(std::memory_order_acquire), stats_of());
   }
   
   const_iterator cend() const noexcept {
-    return const_iterator(nullptr, m_tail.load(std::memory_order_acquire));
+    static_assert(!is_queue, "Queue modes link m_next only, walk them with prefetched()");
+    return const_iterator(nullptr, m_tail.load(std::memory_order_acquire), stats_of());
   }
   
+  /* Range for a prefetching forward walk, for (auto& node : list.prefetched<8>()) */
+  template <size_t Distance = 8>
+  prefetch_range<Distance> prefetched() noexcept {
+    return prefetch_range<Distance>{this};
+  }
+
+  /* Totals of the contention counters, all zero with No_stats */
+  List_stats stats() const noexcept {
+    return m_stats.snapshot();
+  }
+
+  void reset_stats() noexcept {
+    m_stats.reset();
+  }
+
+  stats_ref stats_of() const noexcept {
+    if constexpr (Stats::enabled) {
+      return &m_stats;
+    } else {
+      return {};
+    }
+  }
+
   /* Print the list */
   void print() {
     auto current = m_head.load(std::memory_order_acquire);
@@ -579,6 +2084,268 @@ struct Lock_free_list {
   std::atomic<Node::Tag> m_head{};
   std::atomic<Node::Tag> m_tail{};
 
+  /* Snapshot epoch, bumped by every snapshot */
+  std::atomic<uint64_t> m_epoch{1};
+
+  /* Number of open snapshots */
+  std::atomic<uint32_t> m_snapshots{};
+
+  /* Nodes stamped by remove() and still linked, see retire(). One taken
+  off by pop_front() or detach_all() first stays counted until clear(), the
+  sweeps then just walk as if the count was not there. */
+  std::atomic<uint32_t> m_retired{};
+
+  /* Consumers parked in pop_front_wait() */
+  std::atomic<uint32_t> m_waiters{};
+
+  /* Futex word, bumped by a push that finds a waiter */
+  std::atomic<uint32_t> m_wake_seq{};
+
+  /* Coroutines parked in next() */
+  std::atomic<List_waiter*> m_awaiters{};
+
+  /* Coroutines woken for a Queue_executor, newest first */
+  std::atomic<List_waiter*> m_woken{};
+
+  /* eventfd from open_eventfd(), -1 if none */
+  std::atomic<int> m_event_fd{-1};
+
+  /* The eventfd was signalled and not yet acknowledged */
+  std::atomic<bool> m_event_pending{};
+
+  /* Mutable so that const iterators can count */
+  [[no_unique_address]] mutable Stats m_stats{};
 };
 
+/* Many producers and one draining consumer, push_back() is wait-free */
+template <typename T>
+using Mpsc_list = Lock_free_list<T, Concurrency::MPSC>;
+
+/* A list consumers can wait on */
+template <typename T, Concurrency Mode = Concurrency::MPMC>
+using Blocking_list = Lock_free_list<T, Mode, No_stats, true>;
+
+namespace detail {
+
+/* Shared traversal cursor for the parallel walkers. Following m_next is a
+chain of dependent loads that no number of threads can speed up, so one
+worker at a time walks: it takes the cursor, gathers the next chunk_size
+node pointers and puts the cursor back past them, then works on its chunk
+while the others gather theirs. The walk stays serial, the speedup comes
+from the work done per node, a pass that only chases pointers gains
+nothing from more threads. */
+struct Chunk_cursor {
+  explicit Chunk_cursor(Node* head) noexcept : m_cursor(head) {}
+
+  /* Fill chunk with the next nodes, returns false once the list is exhausted */
+  bool claim(std::vector<Node*>& chunk, size_t chunk_size) {
+    chunk.clear();
+
+    for (;;) {
+      auto start = m_cursor.exchange(busy(), std::memory_order_acquire);
+
+      if (start != busy()) {
+        auto current = start;
+
+        while (current != nullptr && chunk.size() < chunk_size) {
+          chunk.push_back(current);
+          current = (Node*)current->m_next.load(std::memory_order_acquire);
+        }
+
+        m_cursor.store(current, std::memory_order_release);
+        return !chunk.empty();
+      }
+
+      /* Another worker is gathering its chunk */
+      while (m_cursor.load(std::memory_order_relaxed) == busy()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /* Stop handing out chunks, a worker failed */
+  void cancel() noexcept {
+    for (;;) {
+      auto cursor = m_cursor.load(std::memory_order_relaxed);
+
+      if (cursor != busy() && m_cursor.compare_exchange_weak(cursor, nullptr, std::memory_order_relaxed)) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  static Node* busy() noexcept {
+    return reinterpret_cast<Node*>(uintptr_t{1});
+  }
+
+  alignas(64) std::atomic<Node*> m_cursor;
+};
+
+/* Run make_worker() on n_threads threads (the caller is one of them), each
+worker is called with every chunk it claims. The first exception thrown by
+make_worker() or a worker stops the walk and is rethrown once all threads
+are joined. */
+template <typename T, Concurrency M, typename S, bool B, typename Make_worker>
+void parallel_walk(Lock_free_list<T, M, S, B>& list, Make_worker make_worker, size_t n_threads, size_t chunk_size) {
+  if (n_threads == 0) {
+    n_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  chunk_size = std::max<size_t>(chunk_size, 1);
+
+  Chunk_cursor cursor(list.m_head.load(std::memory_order_acquire));
+  std::exception_ptr error;
+  std::atomic_flag failed{};
+
+  auto run = [&]() {
+    try {
+      auto worker = make_worker();
+      std::vector<Node*> chunk;
+
+      chunk.reserve(chunk_size);
+
+      while (cursor.claim(chunk, chunk_size)) {
+        worker(chunk);
+      }
+    } catch (...) {
+      if (!failed.test_and_set()) {
+        error = std::current_exception();
+      }
+      cursor.cancel();
+    }
+  };
+
+  std::vector<std::thread> threads;
+
+  threads.reserve(n_threads - 1);
+
+  for (size_t i = 1; i < n_threads; ++i) {
+    threads.emplace_back(run);
+  }
+
+  run();
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+} // namespace detail
+
+/* Call fn(T&) for every node in the list using n_threads threads, zero means
+one per hardware thread. Nodes are handed out in chunks of consecutive nodes
+so the order fn sees them in is only preserved within a chunk. Like the
+iterators the traversal is not a snapshot, nodes inserted or removed during
+the walk may or may not be visited. */
+template <typename T, Concurrency M, typename S, bool B, typename Fn>
+void parallel_for_each(Lock_free_list<T, M, S, B>& list, Fn fn, size_t n_threads = 0, size_t chunk_size = 512) {
+  detail::parallel_walk(list, [&fn]() {
+    return [&fn](const std::vector<Node*>& chunk) {
+      for (auto node : chunk) {
+        fn(*static_cast<T*>(node));
+      }
+    };
+  }, n_threads, chunk_size);
+}
+
+/* Map every node to an R and fold the results with combine. Each thread
+folds into its own accumulator starting from init, so init must be the
+identity of combine, the per-thread results are combined at the end. */
+template <typename T, Concurrency M, typename S, bool B, typename R, typename Map, typename Combine>
+R parallel_reduce(Lock_free_list<T, M, S, B>& list, R init, Map map, Combine combine, size_t n_threads = 0, size_t chunk_size = 512) {
+  struct Partial {
+    R m_value;
+    Partial* m_next;
+  };
+
+  /* Lock-free stack of one accumulator per worker, owns them */
+  struct Partials {
+    ~Partials() {
+      for (auto partial = m_top.load(std::memory_order_acquire); partial != nullptr;) {
+        delete std::exchange(partial, partial->m_next);
+      }
+    }
+
+    std::atomic<Partial*> m_top{};
+  };
+
+  Partials partials;
+
+  auto make_worker = [&]() {
+    auto partial = new Partial{init, partials.m_top.load(std::memory_order_relaxed)};
+
+    while (!partials.m_top.compare_exchange_weak(partial->m_next, partial, std::memory_order_release, std::memory_order_relaxed)) {}
+
+    return [partial, &map, &combine](const std::vector<Node*>& chunk) {
+      for (auto node : chunk) {
+        partial->m_value = combine(std::move(partial->m_value), map(*static_cast<T*>(node)));
+      }
+    };
+  };
+
+  detail::parallel_walk(list, make_worker, n_threads, chunk_size);
+
+  R result = init;
+
+  for (auto partial = partials.m_top.load(std::memory_order_acquire); partial != nullptr; partial = partial->m_next) {
+    result = combine(std::move(result), std::move(partial->m_value));
+  }
+
+  return result;
+}
+
+/* Prefetch distance used by gather() */
+constexpr size_t gather_prefetch_distance = 16;
+
+/* Copy proj(node) for the nodes from it onwards into out, stops at end or
+when out is full. Returns the number of elements written and leaves it on
+the first node not copied, so calling again continues the walk. */
+template <typename Iterator, typename Out, typename Projection>
+size_t gather(Iterator& it, const Iterator& end, std::span<Out> out, Projection proj) {
+  size_t n{};
+
+  while (n < out.size() && it != end) {
+    out[n++] = proj(*it);
+    ++it;
+  }
+
+  return n;
+}
+
+/* Copy proj(node) for the first out.size() nodes of the list into out,
+returns the number of elements written */
+template <typename T, Concurrency M, typename S, bool B, typename Out, typename Projection>
+size_t gather(Lock_free_list<T, M, S, B>& list, std::span<Out> out, Projection proj) {
+  auto range = list.template prefetched<gather_prefetch_distance>();
+  auto it = range.begin();
+
+  return gather(it, range.end(), out, proj);
+}
+
+/* Walk the whole list, projecting the nodes into buffer one chunk at a
+time and calling fn(std::span<const Out>) on each filled chunk. Lets fn run
+vectorizable reductions and filters over contiguous data while the walk
+keeps the pointer chasing and prefetching in one place. An empty buffer
+throws std::invalid_argument, no chunk could ever be filled. */
+template <typename T, Concurrency M, typename S, bool B, typename Out, typename Projection, typename Fn>
+void for_each_chunk(Lock_free_list<T, M, S, B>& list, std::span<Out> buffer, Projection proj, Fn fn) {
+  if (buffer.empty()) {
+    throw std::invalid_argument("for_each_chunk needs a non-empty buffer");
+  }
+
+  auto range = list.template prefetched<gather_prefetch_distance>();
+  auto end = range.end();
+
+  for (auto it = range.begin(); it != end;) {
+    const auto n = gather(it, end, buffer, proj);
+
+    fn(std::span<const Out>(buffer.data(), n));
+  }
+}
+
 } // namespace ut
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
+
+#include "lockfreelist.h"
+
+namespace ut {
+
+namespace numa {
+
+/* Parse a sysfs cpu or node list, "0-3,8,10-11" */
+inline std::vector<int> parse_list(const std::string& list) {
+  std::vector<int> ids;
+  size_t pos{};
+
+  while (pos < list.size()) {
+    auto end = list.find(',', pos);
+
+    if (end == std::string::npos) {
+      end = list.size();
+    }
+
+    const auto range = list.substr(pos, end - pos);
+    const auto dash = range.find('-');
+
+    if (!range.empty() && range[0] != '\n') {
+      const int first = std::stoi(range);
+      const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+      for (int id = first; id <= last; ++id) {
+        ids.push_back(id);
+      }
+    }
+    pos = end + 1;
+  }
+  return ids;
+}
+
+inline std::string read_line(const std::string& path) {
+  std::ifstream in(path);
+  std::string line;
+
+  std::getline(in, line);
+  return line;
+}
+
+/* Which CPUs belong to which node, read from sysfs once. Without
+/sys/devices/system/node the machine is one node holding every CPU. */
+struct Topology {
+  static const Topology& get() {
+    static const Topology topology;
+    return topology;
+  }
+
+  Topology() {
+    const auto nodes = parse_list(read_line("/sys/devices/system/node/online"));
+
+    for (auto node : nodes) {
+      if (size_t(node) >= m_node_cpus.size()) {
+        m_node_cpus.resize(node + 1);
+      }
+
+      for (auto cpu : parse_list(read_line("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+        if (size_t(cpu) >= m_cpu_node.size()) {
+          m_cpu_node.resize(cpu + 1, 0);
+        }
+        m_cpu_node[cpu] = node;
+        m_node_cpus[node].push_back(cpu);
+      }
+    }
+
+    if (m_node_cpus.empty()) {
+      const auto n_cpus = std::max<long>(1, sysconf(_SC_NPROCESSORS_CONF));
+
+      m_node_cpus.resize(1);
+      m_cpu_node.assign(n_cpus, 0);
+
+      for (int cpu = 0; cpu < n_cpus; ++cpu) {
+        m_node_cpus[0].push_back(cpu);
+      }
+    }
+  }
+
+  int node_count() const noexcept {
+    return int(m_node_cpus.size());
+  }
+
+  int node_of_cpu(int cpu) const noexcept {
+    return cpu >= 0 && size_t(cpu) < m_cpu_node.size() ? m_cpu_node[cpu] : 0;
+  }
+
+  const std::vector<int>& cpus_of(int node) const noexcept {
+    return m_node_cpus[node];
+  }
+
+  std::vector<int> m_cpu_node;
+
+  std::vector<std::vector<int>> m_node_cpus;
+};
+
+/* Node of the CPU the caller is running on right now */
+inline int current_node() noexcept {
+  return Topology::get().node_of_cpu(sched_getcpu());
+}
+
+/* Node the page holding addr is on, -1 if it is not faulted in or the
+kernel does not tell us */
+inline int node_of(const void* addr) noexcept {
+  int node = -1;
+
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, MPOL_F_NODE | MPOL_F_ADDR) != 0) {
+    return -1;
+  }
+  return node;
+}
+
+/* Prefer node for the pages of [addr, addr + len) that are not faulted in
+yet. Fails without NUMA support or under a seccomp policy, the pages then
+go wherever first touch puts them. */
+inline bool prefer_node(void* addr, size_t len, int node) noexcept {
+  unsigned long mask[4]{};
+
+  if (node < 0 || size_t(node) >= sizeof(mask) * 8) {
+    return false;
+  }
+
+  mask[node / 64] = 1UL << (node % 64);
+  return syscall(SYS_mbind, addr, len, MPOL_PREFERRED, mask, sizeof(mask) * 8, 0) == 0;
+}
+
+/* Fixed size blocks for T carved out of chunks whose pages are bound to
+one node. A node's free list is a Treiber stack with a 16 bit counter in
+the top bits of the head against ABA. Chunks are unmapped when the arena
+is destroyed, so reading a free block's link after it was handed out is
+harmless: the stale CAS fails on the counter. */
+template <typename T>
+struct Arena {
+  static constexpr size_t chunk_size = size_t{2} << 20;
+
+  static constexpr size_t block_align = std::max<size_t>(alignof(T), alignof(void*));
+
+  static constexpr size_t block_size = (std::max(sizeof(T), sizeof(void*)) + block_align - 1) & ~(block_align - 1);
+
+  static constexpr uint64_t ptr_bits = 48;
+  static constexpr uint64_t ptr_mask = (uint64_t{1} << ptr_bits) - 1;
+
+  struct Free {
+    Free* m_next;
+  };
+
+  struct Chunk {
+    int m_node;
+
+    Chunk* m_next;
+
+    std::atomic<size_t> m_used;
+  };
+
+  static constexpr size_t first_block = (sizeof(Chunk) + block_align - 1) & ~(block_align - 1);
+
+  struct alignas(64) Pool {
+    /* Free list head, pointer in the low 48 bits and a counter above */
+    std::atomic<uint64_t> m_free{};
+
+    /* Chunk we bump allocate from */
+    std::atomic<Chunk*> m_current{};
+
+    /* Every chunk of this node, to unmap them */
+    std::atomic<Chunk*> m_chunks{};
+  };
+
+  Arena()
+    : m_pools(std::make_unique<Pool[]>(Topology::get().node_count())),
+      m_n_pools(Topology::get().node_count()) {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena() {
+    for (int node = 0; node < m_n_pools; ++node) {
+      auto chunk = m_pools[node].m_chunks.load(std::memory_order_acquire);
+
+      while (chunk != nullptr) {
+        auto next = chunk->m_next;
+
+        munmap(chunk, chunk_size);
+        chunk = next;
+      }
+    }
+  }
+
+  /* Construct a T in memory on node */
+  template <typename... Args>
+  T* create(int node, Args&&... args) {
+    return new (allocate(node)) T(std::forward<Args>(args)...);
+  }
+
+  /* Construct a T in memory on the caller's node */
+  template <typename... Args>
+  T* create_local(Args&&... args) {
+    return create(current_node(), std::forward<Args>(args)...);
+  }
+
+  /* Destroy obj and return its block to the node it came from */
+  void destroy(T* obj) noexcept {
+    obj->~T();
+
+    auto chunk = reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(obj) & ~(chunk_size - 1));
+    auto& pool = m_pools[chunk->m_node];
+    auto block = reinterpret_cast<Free*>(obj);
+    auto head = pool.m_free.load(std::memory_order_relaxed);
+
+    do {
+      block->m_next = reinterpret_cast<Free*>(head & ptr_mask);
+    } while (!pool.m_free.compare_exchange_weak(head, next_head(head, block), std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  void* allocate(int node) {
+    if (node < 0 || node >= m_n_pools) {
+      node = 0;
+    }
+
+    auto& pool = m_pools[node];
+    auto head = pool.m_free.load(std::memory_order_acquire);
+
+    while ((head & ptr_mask) != 0) {
+      auto block = reinterpret_cast<Free*>(head & ptr_mask);
+
+      if (pool.m_free.compare_exchange_weak(head, next_head(head, block->m_next), std::memory_order_acquire, std::memory_order_acquire)) {
+        return block;
+      }
+    }
+
+    for (;;) {
+      auto chunk = pool.m_current.load(std::memory_order_acquire);
+
+      if (chunk != nullptr) {
+        const auto offset = chunk->m_used.fetch_add(block_size, std::memory_order_relaxed);
+
+        if (offset + block_size <= chunk_size) {
+          return reinterpret_cast<char*>(chunk) + offset;
+        }
+      }
+
+      /* Chunk is used up, whoever installs the next one wins */
+      auto fresh = map_chunk(node);
+
+      if (pool.m_current.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        auto chunks = pool.m_chunks.load(std::memory_order_relaxed);
+
+        do {
+          fresh->m_next = chunks;
+        } while (!pool.m_chunks.compare_exchange_weak(chunks, fresh, std::memory_order_release, std::memory_order_relaxed));
+      } else {
+        munmap(fresh, chunk_size);
+      }
+    }
+  }
+
+  static uint64_t next_head(uint64_t head, Free* block) noexcept {
+    return ((head & ~ptr_mask) + (uint64_t{1} << ptr_bits)) | reinterpret_cast<uint64_t>(block);
+  }
+
+  /* Map a chunk_size aligned chunk and bind it to node before touching it */
+  static Chunk* map_chunk(int node) {
+    auto raw = mmap(nullptr, chunk_size * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (raw == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+
+    /* Trim to an aligned chunk so a block finds its chunk by masking */
+    const auto start = reinterpret_cast<uintptr_t>(raw);
+    const auto aligned = (start + chunk_size - 1) & ~(chunk_size - 1);
+
+    if (aligned > start) {
+      munmap(raw, aligned - start);
+    }
+    munmap(reinterpret_cast<void*>(aligned + chunk_size), start + chunk_size - aligned);
+
+    auto chunk = reinterpret_cast<Chunk*>(aligned);
+
+    prefer_node(chunk, chunk_size, node);
+
+    chunk->m_node = node;
+    chunk->m_next = nullptr;
+    new (&chunk->m_used) std::atomic<size_t>(first_block);
+    return chunk;
+  }
+
+  std::unique_ptr<Pool[]> m_pools;
+
+  int m_n_pools;
+};
+
+} // namespace numa
+
+/* One Lock_free_list per NUMA node. Threads push to and pop from the list
+of the node they run on, so the head CAS and the nodes stay node local,
+and steal from the other nodes' lists when their own is empty. There is
+no order across shards. */
+template <typename T>
+struct Numa_sharded_list {
+  struct alignas(64) Shard {
+    Lock_free_list<T> m_list;
+  };
+
+  /* One shard per node by default, more shards are mapped round robin */
+  explicit Numa_sharded_list(int n_shards = numa::Topology::get().node_count())
+    : m_shards(std::make_unique<Shard[]>(n_shards)),
+      m_n_shards(n_shards) {}
+
+  Numa_sharded_list(const Numa_sharded_list&) = delete;
+  Numa_sharded_list& operator=(const Numa_sharded_list&) = delete;
+
+  /* Shard of the caller's node */
+  int local_shard() const noexcept {
+    return numa::current_node() % m_n_shards;
+  }
+
+  void push(Node* node) {
+    push(node, local_shard());
+  }
+
+  void push(Node* node, int shard) {
+    m_shards[shard].m_list.push_front(node);
+  }
+
+  /* Pop from the local shard, else steal from the others in order */
+  Node* pop() {
+    return pop(local_shard());
+  }
+
+  Node* pop(int shard) {
+    for (int i = 0; i < m_n_shards; ++i) {
+      if (auto node = m_shards[(shard + i) % m_n_shards].m_list.pop_front(); node != nullptr) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  /* Visit every node, shard by shard */
+  template <typename Fn>
+  void for_each(Fn fn) {
+    for (int i = 0; i < m_n_shards; ++i) {
+      for (auto& node : m_shards[i].m_list) {
+        fn(node);
+      }
+    }
+  }
+
+  Lock_free_list<T>& shard(int i) noexcept {
+    return m_shards[i].m_list;
+  }
+
+  int shard_count() const noexcept {
+    return m_n_shards;
+  }
+
+  std::unique_ptr<Shard[]> m_shards;
+
+  int m_n_shards;
+};
+
+} // namespace ut
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <type_traits>
+
+namespace ut::detail {
+
+/* Copies of trivially copyable values that another thread may rewrite at
+the same time. Whole-value relaxed atomic accesses where they are
+lock-free, bytewise otherwise. A reader has to validate the copy itself,
+like a seqlock, these only keep the race defined. */
+template <typename T>
+inline constexpr bool relaxed_whole_value =
+  std::atomic_ref<T>::is_always_lock_free && alignof(T) >= std::atomic_ref<T>::required_alignment;
+
+template <typename T>
+T load_relaxed(const T& src) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  if constexpr (relaxed_whole_value<T>) {
+    return std::atomic_ref<T>(const_cast<T&>(src)).load(std::memory_order_relaxed);
+  } else {
+    std::array<unsigned char, sizeof(T)> bytes;
+    auto from = reinterpret_cast<const unsigned char*>(&src);
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      bytes[i] = __atomic_load_n(from + i, __ATOMIC_RELAXED);
+    }
+    return std::bit_cast<T>(bytes);
+  }
+}
+
+template <typename T>
+void store_relaxed(T& dst, const T& value) noexcept {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+  if constexpr (relaxed_whole_value<T>) {
+    std::atomic_ref<T>(dst).store(value, std::memory_order_relaxed);
+  } else {
+    const auto bytes = std::bit_cast<std::array<unsigned char, sizeof(T)>>(value);
+    auto to = reinterpret_cast<unsigned char*>(&dst);
+
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      __atomic_store_n(to + i, bytes[i], __ATOMIC_RELAXED);
+    }
+  }
+}
+
+} // namespace ut::detail
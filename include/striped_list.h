@@ -0,0 +1,196 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#include "lockfreelist.h"
+
+namespace ut {
+
+/* N independent lists on their own cache lines. A thread pushes to the
+stripe it was assigned on first use, so pushes from different threads
+rarely CAS the same head. There is no order across stripes: iteration
+walks the stripes one after the other and pop() probes them starting at
+the caller's. Use it when only membership matters. */
+template <typename T, size_t N = 16>
+struct Striped_lock_free_list {
+  static_assert(N > 0, "Need at least one stripe");
+  static_assert(std::is_base_of_v<Striped_node, T>, "Striped lists need nodes derived from ut::Striped_node");
+
+  struct alignas(64) Stripe {
+    Lock_free_list<T> m_list;
+  };
+
+  /* Forward iterator over all stripes, relaxed order */
+  struct iterator {
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    iterator() noexcept = default;
+
+    iterator(Striped_lock_free_list* list, size_t stripe) noexcept
+      : m_list(list), m_stripe(stripe) {
+      enter_stripe();
+    }
+
+    reference operator*() const noexcept {
+      return *static_cast<T*>(m_node);
+    }
+
+    pointer operator->() const noexcept {
+      return static_cast<T*>(m_node);
+    }
+
+    iterator& operator++() noexcept {
+      m_node = m_node->m_next.load(std::memory_order_acquire);
+
+      if (m_node == nullptr) {
+        ++m_stripe;
+        enter_stripe();
+      }
+      return *this;
+    }
+
+    iterator operator++(int) noexcept {
+      auto tmp = *this;
+
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const iterator& rhs) const noexcept {
+      return m_node == rhs.m_node;
+    }
+
+    bool operator!=(const iterator& rhs) const noexcept {
+      return !(*this == rhs);
+    }
+
+    /* Move to the first node of the first non empty stripe from m_stripe on */
+    void enter_stripe() noexcept {
+      for (; m_stripe < N; ++m_stripe) {
+        m_node = m_list->m_stripes[m_stripe].m_list.m_head.load(std::memory_order_acquire);
+
+        if (m_node != nullptr) {
+          return;
+        }
+      }
+      m_node = nullptr;
+    }
+
+    Striped_lock_free_list* m_list{};
+
+    size_t m_stripe{N};
+
+    Node* m_node{};
+  };
+
+  Striped_lock_free_list() = default;
+
+  Striped_lock_free_list(const Striped_lock_free_list&) = delete;
+  Striped_lock_free_list& operator=(const Striped_lock_free_list&) = delete;
+
+  /* Stripe of the calling thread, threads are dealt out round robin */
+  size_t local_stripe() noexcept {
+    return detail::thread_index() % N;
+  }
+
+  /* Push to the calling thread's stripe */
+  void push(Node* node) {
+    push_to(node, local_stripe());
+  }
+
+  /* Push to the stripe key hashes to, equal keys share a stripe */
+  template <typename Key>
+  void push(Node* node, const Key& key) {
+    push_to(node, std::hash<Key>{}(key) % N);
+  }
+
+  /* Pop from the calling thread's stripe, else probe the others */
+  Node* pop() {
+    const auto start = local_stripe();
+
+    for (size_t i = 0; i < N; ++i) {
+      if (auto node = m_stripes[(start + i) % N].m_list.pop_front(); node != nullptr) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  /* Remove a node pushed with push() from the stripe it went to */
+  void remove(Node* node) {
+    stripe_of(node).remove(node);
+  }
+
+  /* The stripe push() put a node on, recorded in the node */
+  Lock_free_list<T>& stripe_of(const Node* node) noexcept {
+    const auto stripe = static_cast<const Striped_node*>(static_cast<const T*>(node))->m_stripe;
+
+    assert(stripe < N);
+    return m_stripes[stripe].m_list;
+  }
+
+  /* Find a node matching pred on any stripe */
+  template <typename Predicate>
+  Node* find_if(Predicate pred) {
+    for (auto it = begin(); it != end(); ++it) {
+      if (pred(&*it)) {
+        return it.m_node;
+      }
+    }
+    return nullptr;
+  }
+
+  /* Number of nodes, exact only when there are no writers */
+  size_t size() noexcept {
+    size_t n{};
+
+    for (auto it = begin(); it != end(); ++it) {
+      ++n;
+    }
+    return n;
+  }
+
+  bool empty() noexcept {
+    return begin() == end();
+  }
+
+  iterator begin() noexcept {
+    return iterator(this, 0);
+  }
+
+  iterator end() noexcept {
+    return iterator();
+  }
+
+  Lock_free_list<T>& stripe(size_t i) noexcept {
+    return m_stripes[i].m_list;
+  }
+
+  static constexpr size_t stripe_count() noexcept {
+    return N;
+  }
+
+  void clear() {
+    for (auto& stripe : m_stripes) {
+      stripe.m_list.clear();
+    }
+  }
+
+  /* The stripe is recorded before the node is published */
+  void push_to(Node* node, size_t stripe) {
+    static_cast<Striped_node*>(static_cast<T*>(node))->m_stripe = static_cast<uint32_t>(stripe);
+    m_stripes[stripe].m_list.push_front(node);
+  }
+
+  Stripe m_stripes[N];
+};
+
+} // namespace ut
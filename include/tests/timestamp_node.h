@@ -1,5 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
 
@@ -14,7 +17,196 @@ struct DataNode : public ut::Node {
   value_type m_value;
 };
 
-struct TimestampNode : public ut::Node {
+// Node for lists that take snapshots
+struct VersionedDataNode : public ut::Versioned_node {
+  using value_type = int;
+
+  explicit VersionedDataNode(int v)
+    : m_value(v) {}
+
+  value_type m_value;
+};
+
+// Node for striped lists
+struct StripedDataNode : public ut::Striped_node {
+  using value_type = int;
+
+  explicit StripedDataNode(int v)
+    : m_value(v) {}
+
+  value_type m_value;
+};
+
+// Access counting policies for TimestampNode.
+//
+// A single shared atomic turns a hot node into a cache line that every
+// reader has to own exclusively. The sharded counter spreads the writes over
+// several lines and the Morris counter trades exactness for rare writes.
+// Only Exact_counter's value() is a point-in-time count.
+namespace access_counter {
+
+namespace detail {
+    // Cheap per-thread xorshift generator for the probabilistic counters
+    inline uint64_t thread_random() {
+        thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ (ut::detail::thread_index() + 1) * 0xBF58476D1CE4E5B9ull;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    // Number of exponents c of a Morris counter with a^-c >= 2^-64
+    template<unsigned Scale>
+    constexpr size_t morris_threshold_count() {
+        size_t n = 0;
+        for (double p = 1.0; p * 0x1.0p64 >= 1.0; p *= double(Scale) / (Scale + 1)) {
+            ++n;
+        }
+        return n;
+    }
+
+    // a^-c scaled to 2^64 for every such exponent
+    template<unsigned Scale>
+    inline constexpr auto morris_thresholds = [] {
+        std::array<uint64_t, morris_threshold_count<Scale>()> thresholds{};
+        double p = 1.0;
+
+        for (auto& threshold : thresholds) {
+            threshold = p >= 1.0 ? ~uint64_t{0} : uint64_t(p * 0x1.0p64);
+            p *= double(Scale) / (Scale + 1);
+        }
+        return thresholds;
+    }();
+}
+
+// Exact count in one atomic, every access is a read-modify-write
+struct Exact_counter {
+    void increment() {
+        m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        m_count.store(0, std::memory_order_relaxed);
+    }
+
+    // Divide the count by 2^halvings, increments racing with this may be lost
+    void decay(unsigned halvings = 1) {
+        auto count = m_count.load(std::memory_order_relaxed);
+        while (!m_count.compare_exchange_weak(count, halvings < 64 ? count >> halvings : 0, std::memory_order_relaxed)) {}
+    }
+
+    std::atomic<uint64_t> m_count{0};
+};
+
+// Count spread over cache-line sized shards that threads take round-robin,
+// threads share a shard once there are more than Shards of them. No
+// increment is lost, but value() sums the shards one at a time, so it can
+// miss increments that race with it. Costs Shards * 64 bytes per node, so
+// use it for the few nodes that are really hot.
+template<size_t Shards = 16>
+struct Sharded_counter {
+    static_assert(Shards > 0, "Need at least one shard");
+
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> m_count{0};
+    };
+
+    void increment() {
+        m_shards[ut::detail::thread_index() % Shards].m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total{};
+        for (const auto& shard : m_shards) {
+            total += shard.m_count.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void reset() {
+        for (auto& shard : m_shards) {
+            shard.m_count.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void decay(unsigned halvings = 1) {
+        for (auto& shard : m_shards) {
+            auto count = shard.m_count.load(std::memory_order_relaxed);
+            while (!shard.m_count.compare_exchange_weak(count, halvings < 64 ? count >> halvings : 0, std::memory_order_relaxed)) {}
+        }
+    }
+
+    std::array<Shard, Shards> m_shards{};
+};
+
+// Morris style approximate counter. Only the exponent c is stored and it is
+// bumped with probability a^-c where a = 1 + 1/Scale, so the estimate
+// Scale * (a^c - 1) tracks the true count while writes become exponentially
+// rare. A hot node's line stays shared between readers most of the time.
+// Larger Scale means smaller error and more frequent writes. The
+// probabilities are a table of 64-bit thresholds built at compile time, so
+// an access is one random number and one compare; the exponent stops where
+// the probability drops below 2^-64.
+template<unsigned Scale = 8>
+struct Morris_counter {
+    static_assert(Scale > 0, "Scale must be positive");
+    static_assert(Scale <= 256, "The threshold table grows linearly with Scale");
+
+    void increment() {
+        auto c = m_exponent.load(std::memory_order_relaxed);
+
+        if (c == 0) {
+            /* First access is always counted */
+            m_exponent.compare_exchange_strong(c, 1, std::memory_order_relaxed);
+            return;
+        }
+
+        const auto& thresholds = detail::morris_thresholds<Scale>;
+
+        if (c < thresholds.size() && detail::thread_random() < thresholds[c]) {
+            /* Losing the race to another reader is fine, it counted for us */
+            m_exponent.compare_exchange_strong(c, c + 1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t value() const {
+        return estimate(m_exponent.load(std::memory_order_relaxed));
+    }
+
+    void reset() {
+        m_exponent.store(0, std::memory_order_relaxed);
+    }
+
+    // Pick the exponent whose estimate is closest to value() / 2^halvings
+    void decay(unsigned halvings = 1) {
+        auto c = m_exponent.load(std::memory_order_relaxed);
+        uint32_t decayed;
+
+        do {
+            const double target = std::ldexp(double(estimate(c)), -int(std::min(halvings, 64u)));
+            decayed = uint32_t(std::lround(std::log1p(target / Scale) / log_base()));
+        } while (decayed < c && !m_exponent.compare_exchange_weak(c, decayed, std::memory_order_relaxed));
+    }
+
+    static double log_base() {
+        return std::log1p(1.0 / Scale);
+    }
+
+    static uint64_t estimate(uint32_t c) {
+        return uint64_t(std::llround(Scale * std::expm1(double(c) * log_base())));
+    }
+
+    std::atomic<uint32_t> m_exponent{0};
+};
+
+} // namespace access_counter
+
+template<typename Access_counter = access_counter::Exact_counter>
+struct Basic_timestamp_node : public ut::Node {
     using value_type = int;
 
     using clock_type = std::chrono::steady_clock;
@@ -23,15 +215,15 @@ struct TimestampNode : public ut::Node {
     
     int m_value;
     time_point timestamp;
-    std::atomic<uint64_t> access_count{0};  // Track number of times node is accessed
+    Access_counter access_count{};  // Track number of times node is accessed
     
-    explicit TimestampNode(int v) 
+    explicit Basic_timestamp_node(int v) 
         : m_value(v)
         , timestamp(clock_type::now()) 
     {}
     
     // Copy constructor with new timestamp
-    TimestampNode(const TimestampNode& other)
+    Basic_timestamp_node(const Basic_timestamp_node& other)
         : m_value(other.m_value)
         , timestamp(clock_type::now())
     {}
@@ -59,17 +251,23 @@ struct TimestampNode : public ut::Node {
     
     // Track node access
     void record_access() {
-        access_count.fetch_add(1, std::memory_order_relaxed);
+        access_count.increment();
     }
     
-    // Get access count
+    // Get access count, approximate for the Morris counter and possibly
+    // missing racing increments for the sharded one
     uint64_t get_access_count() const {
-        return access_count.load(std::memory_order_relaxed);
+        return access_count.value();
     }
     
     // Reset access count
     void reset_access_count() {
-        access_count.store(0, std::memory_order_relaxed);
+        access_count.reset();
+    }
+    
+    // Age the access count for LFU, each halving divides it by two
+    void decay_access_count(unsigned halvings = 1) {
+        access_count.decay(halvings);
     }
     
     // Update timestamp to current time
@@ -98,21 +296,21 @@ struct TimestampNode : public ut::Node {
     }
     
     // Comparison operators
-    bool operator<(const TimestampNode& other) const {
+    bool operator<(const Basic_timestamp_node& other) const {
         return m_value < other.m_value;
     }
     
-    bool operator==(const TimestampNode& other) const {
+    bool operator==(const Basic_timestamp_node& other) const {
         return m_value == other.m_value;
     }
     
     // Static helper methods
-    static TimestampNode* create_node(int value) {
-        return new TimestampNode(value);
+    static Basic_timestamp_node* create_node(int value) {
+        return new Basic_timestamp_node(value);
     }
     
-    static std::vector<TimestampNode*> create_nodes(const std::vector<int>& values) {
-        std::vector<TimestampNode*> nodes;
+    static std::vector<Basic_timestamp_node*> create_nodes(const std::vector<int>& values) {
+        std::vector<Basic_timestamp_node*> nodes;
         nodes.reserve(values.size());
         for (int val : values) {
             nodes.push_back(create_node(val));
@@ -122,12 +320,18 @@ struct TimestampNode : public ut::Node {
     
     // Custom deleter for use with smart pointers
     struct Deleter {
-        void operator()(TimestampNode* node) const {
+        void operator()(Basic_timestamp_node* node) const {
             delete node;
         }
     };
 };
 
+using TimestampNode = Basic_timestamp_node<>;
+
+// Timestamp nodes for read-mostly hot spots
+using ShardedTimestampNode = Basic_timestamp_node<access_counter::Sharded_counter<>>;
+using MorrisTimestampNode = Basic_timestamp_node<access_counter::Morris_counter<>>;
+
 // Helper for creating unique_ptr with TimestampNode
 using TimestampNodePtr = std::unique_ptr<TimestampNode, TimestampNode::Deleter>;
 
@@ -179,5 +383,48 @@ namespace node_utils {
         
         return total_age / count;
     }
+    
+    // Average age over a whole list, traversed by n_threads threads
+    template<typename NodeType>
+    double parallel_average_age_seconds(ut::Lock_free_list<NodeType>& list, size_t n_threads = 0) {
+        struct Sum {
+            double total_age;
+            size_t count;
+        };
+        
+        auto sum = ut::parallel_reduce(list, Sum{0.0, 0},
+            [now = NodeType::clock_type::now()](const NodeType& node) {
+                return Sum{std::chrono::duration<double>(now - node.timestamp).count(), 1};
+            },
+            [](Sum lhs, Sum rhs) {
+                return Sum{lhs.total_age + rhs.total_age, lhs.count + rhs.count};
+            },
+            n_threads);
+        
+        return sum.count == 0 ? 0.0 : sum.total_age / sum.count;
+    }
+    
+    // Halve the access counts of all nodes in range, call periodically for LFU aging
+    template<typename Iterator>
+    void decay_access_counts(Iterator begin, Iterator end, unsigned halvings = 1) {
+        for (auto it = begin; it != end; ++it) {
+            it->decay_access_count(halvings);
+        }
+    }
+    
+    // Find least frequently used node in range, the LFU eviction candidate
+    template<typename Iterator>
+    Iterator find_least_frequent(Iterator begin, Iterator end) {
+        if (begin == end) return end;
+        Iterator victim = begin;
+        auto min_count = victim->get_access_count();
+        for (auto it = std::next(begin); it != end; ++it) {
+            if (auto count = it->get_access_count(); count < min_count) {
+                victim = it;
+                min_count = count;
+            }
+        }
+        return victim;
+    }
 }
 
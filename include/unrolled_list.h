@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+
+#include "relaxed_copy.h"
+
+namespace ut {
+
+/* Lock-free unordered container that stores up to K small values per
+cache-line sized chunk. Chunks form a prepend-only singly linked list and
+are only freed when the container is destroyed, so a reader can always
+follow m_next safely. Most pushes and removes only CAS the slot bitmaps of
+an existing chunk, the chain itself is only touched when every slot we
+look at is taken. Values are copied in and out, T must be trivially
+copyable.
+
+A slot can be taken and refilled while a reader copies it, so slots are
+only read and written with relaxed atomic accesses and a reader checks the
+chunk's ready word after copying, like a seqlock: if the slot was taken or
+anything was published in the chunk since, the copy is redone or the slot
+skipped. Readers never see a torn or recycled value. */
+template <typename T, size_t K = 0>
+struct Unrolled_list {
+  static_assert(std::is_trivially_copyable_v<T>, "Values are copied in and out of slots");
+
+  /* Chunk header: ready word, next pointer and claimed bitmap */
+  static constexpr size_t header_size = sizeof(uint64_t) + sizeof(void*) + sizeof(uint32_t);
+
+  /* Default to as many slots as fit next to the header in one cache line */
+  static constexpr size_t slots = K != 0 ? K : std::max<size_t>(1, std::min<size_t>(32, (64 - header_size) / sizeof(T)));
+
+  static_assert(slots <= 32, "At most 32 slots per chunk");
+
+  /* Chunks from the head a push looks at before allocating a new one */
+  static constexpr size_t max_probe = 16;
+
+  static constexpr uint32_t full_mask = slots == 32 ? ~uint32_t{} : (uint32_t{1} << slots) - 1;
+
+  /* Low 32 bits of the ready word are the published slots, the high 32
+  bits count publishes so a remover can tell that a slot it read was
+  taken and refilled in the meantime */
+  static constexpr uint64_t ready_generation = uint64_t{1} << 32;
+
+  struct alignas(64) Chunk {
+    std::atomic<uint64_t> m_ready{};
+
+    std::atomic<Chunk*> m_next{};
+
+    /* Bit i set: slot i holds a value or is being written */
+    std::atomic<uint32_t> m_claimed{};
+
+    T m_slots[slots];
+  };
+
+  static T load_slot(const T& slot) noexcept {
+    return detail::load_relaxed(slot);
+  }
+
+  static void store_slot(T& slot, const T& value) noexcept {
+    detail::store_relaxed(slot, value);
+  }
+
+  /* Copy a slot that was published in ready. Returns false if the slot was
+  taken meanwhile, otherwise out is a value the slot held while published
+  and ready is the word it was validated against. */
+  static bool read_slot(const Chunk* chunk, uint32_t slot, uint64_t& ready, T& out) noexcept {
+    const auto bit = uint64_t{1} << slot;
+
+    for (;;) {
+      const T value = load_slot(chunk->m_slots[slot]);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      const auto now = chunk->m_ready.load(std::memory_order_relaxed);
+
+      if ((now & bit) == 0) {
+        return false;
+      }
+
+      /* A refill of the slot publishes, which bumps the generation */
+      if ((now ^ ready) < ready_generation) {
+        out = value;
+        return true;
+      }
+      ready = now;
+    }
+  }
+
+  /* Forward iterator over the published values. A chunk's ready bitmap is
+  read once when the iterator enters the chunk and each value is copied
+  into the iterator when it moves onto it, values taken after the chunk was
+  entered are skipped. */
+  struct const_iterator {
+    using value_type = T;
+    using pointer = const T*;
+    using reference = const T&;
+    using difference_type = std::ptrdiff_t;
+    using iterator_category = std::forward_iterator_tag;
+
+    const_iterator() noexcept = default;
+
+    explicit const_iterator(const Chunk* chunk) noexcept
+      : m_chunk(chunk) {
+      enter_chunk();
+    }
+
+    reference operator*() const noexcept {
+      return m_value;
+    }
+
+    pointer operator->() const noexcept {
+      return &m_value;
+    }
+
+    const_iterator& operator++() noexcept {
+      m_pending &= m_pending - 1;
+
+      if (!settle()) {
+        m_chunk = m_chunk->m_next.load(std::memory_order_acquire);
+        enter_chunk();
+      }
+      return *this;
+    }
+
+    const_iterator operator++(int) noexcept {
+      auto tmp = *this;
+
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const const_iterator& rhs) const noexcept {
+      return m_chunk == rhs.m_chunk && (m_chunk == nullptr || m_slot == rhs.m_slot);
+    }
+
+    bool operator!=(const const_iterator& rhs) const noexcept {
+      return !(*this == rhs);
+    }
+
+    /* Skip to the first chunk with a published value */
+    void enter_chunk() noexcept {
+      while (m_chunk != nullptr) {
+        if (auto next = m_chunk->m_next.load(std::memory_order_relaxed); next != nullptr) {
+          __builtin_prefetch(next, 0, 3);
+        }
+
+        m_ready = m_chunk->m_ready.load(std::memory_order_acquire);
+        m_pending = uint32_t(m_ready);
+
+        if (settle()) {
+          return;
+        }
+        m_chunk = m_chunk->m_next.load(std::memory_order_acquire);
+      }
+    }
+
+    /* Move to the first pending slot that is still published and copy it,
+    false if none is left in this chunk */
+    bool settle() noexcept {
+      while (m_pending != 0) {
+        m_slot = std::countr_zero(m_pending);
+
+        if (read_slot(m_chunk, m_slot, m_ready, m_value)) {
+          return true;
+        }
+        m_pending &= m_pending - 1;
+      }
+      return false;
+    }
+
+    const Chunk* m_chunk{};
+
+    /* Ready word m_pending was taken from, or a later one m_value was
+    validated against */
+    uint64_t m_ready{};
+
+    /* Ready slots of m_chunk not visited yet, including m_slot */
+    uint32_t m_pending{};
+
+    uint32_t m_slot{};
+
+    T m_value{};
+  };
+
+  Unrolled_list() = default;
+
+  Unrolled_list(const Unrolled_list&) = delete;
+  Unrolled_list& operator=(const Unrolled_list&) = delete;
+
+  ~Unrolled_list() {
+    auto chunk = m_head.load(std::memory_order_acquire);
+
+    while (chunk != nullptr) {
+      auto next = chunk->m_next.load(std::memory_order_relaxed);
+
+      delete chunk;
+      chunk = next;
+    }
+  }
+
+  /* Add a value, the order of values is not preserved */
+  void push(const T& value) {
+    /* Try the chunk that last had room, then the newest chunks */
+    if (auto hint = m_hint.load(std::memory_order_acquire); hint != nullptr && try_push(hint, value)) {
+      return;
+    }
+
+    auto probe = m_head.load(std::memory_order_acquire);
+
+    for (size_t i = 0; i < max_probe && probe != nullptr; ++i) {
+      if (try_push(probe, value)) {
+        m_hint.store(probe, std::memory_order_release);
+        return;
+      }
+      probe = probe->m_next.load(std::memory_order_acquire);
+    }
+
+    /* Everything we looked at was full, prepend a new chunk that already
+    holds the value so it is published by the same CAS that links it */
+    auto chunk = new Chunk;
+
+    chunk->m_slots[0] = value;
+    chunk->m_claimed.store(1, std::memory_order_relaxed);
+    chunk->m_ready.store(ready_generation | 1, std::memory_order_relaxed);
+
+    auto head = m_head.load(std::memory_order_relaxed);
+
+    do {
+      chunk->m_next.store(head, std::memory_order_relaxed);
+    } while (!m_head.compare_exchange_weak(head, chunk, std::memory_order_release, std::memory_order_relaxed));
+
+    m_hint.store(chunk, std::memory_order_release);
+  }
+
+  /* Remove one value matching pred and copy it to out. Returns false if no
+  published value matched. */
+  template <typename Predicate>
+  bool remove_if(Predicate pred, T& out) {
+    for (auto chunk = m_head.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->m_next.load(std::memory_order_acquire)) {
+      auto ready = chunk->m_ready.load(std::memory_order_acquire);
+      auto pending = uint32_t(ready);
+
+      while (pending != 0) {
+        const auto slot = std::countr_zero(pending);
+
+        /* Possibly torn, take() only succeeds if nothing was published or
+        taken in the chunk since ready, so a value it returns is whole */
+        const T value = load_slot(chunk->m_slots[slot]);
+
+        if (!pred(value)) {
+          pending &= pending - 1;
+          continue;
+        }
+
+        if (take(chunk, slot, ready)) {
+          out = value;
+          return true;
+        }
+
+        /* The ready word changed under us, rescan the chunk with the new one */
+        pending = uint32_t(ready);
+      }
+    }
+
+    return false;
+  }
+
+  template <typename Predicate>
+  bool remove_if(Predicate pred) {
+    T value;
+
+    return remove_if(pred, value);
+  }
+
+  /* Remove one value equal to value */
+  bool remove(const T& value) {
+    return remove_if([&value](const T& v) { return v == value; });
+  }
+
+  /* Remove any one value, the newest chunks are tried first */
+  bool try_pop(T& out) {
+    return remove_if([](const T&) { return true; }, out);
+  }
+
+  /* Copy of the first published value matching pred */
+  template <typename Predicate>
+  bool find_if(Predicate pred, T& out) const {
+    for (const auto& value : *this) {
+      if (pred(value)) {
+        out = value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /* Number of published values, exact only when there are no writers */
+  size_t size() const noexcept {
+    size_t n{};
+
+    for (auto chunk = m_head.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->m_next.load(std::memory_order_acquire)) {
+      n += std::popcount(uint32_t(chunk->m_ready.load(std::memory_order_acquire)));
+    }
+    return n;
+  }
+
+  bool empty() const noexcept {
+    return begin() == end();
+  }
+
+  /* Number of chunks allocated, chunks are reused but never freed */
+  size_t chunk_count() const noexcept {
+    size_t n{};
+
+    for (auto chunk = m_head.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->m_next.load(std::memory_order_acquire)) {
+      ++n;
+    }
+    return n;
+  }
+
+  const_iterator begin() const noexcept {
+    return const_iterator(m_head.load(std::memory_order_acquire));
+  }
+
+  const_iterator end() const noexcept {
+    return const_iterator();
+  }
+
+  /* Claim a free slot in chunk, write the value and publish it */
+  bool try_push(Chunk* chunk, const T& value) {
+    auto claimed = chunk->m_claimed.load(std::memory_order_relaxed);
+
+    for (;;) {
+      const auto free = ~claimed & full_mask;
+
+      if (free == 0) {
+        return false;
+      }
+
+      const auto bit = free & -free;
+
+      if (chunk->m_claimed.compare_exchange_weak(claimed, claimed | bit, std::memory_order_acquire, std::memory_order_relaxed)) {
+        store_slot(chunk->m_slots[std::countr_zero(bit)], value);
+
+        /* The bit is clear, so adding it sets it and bumps the generation */
+        chunk->m_ready.fetch_add(ready_generation | bit, std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  /* Unpublish a slot read under the ready word expected. Fails, updating
+  expected, if any slot of the chunk was published or taken since, so a
+  slot that was emptied and refilled is never taken with its old value.
+  The slot is released for reuse only after the ready bit is gone. */
+  bool take(Chunk* chunk, uint32_t slot, uint64_t& expected) {
+    const auto bit = uint64_t{1} << slot;
+
+    if (!chunk->m_ready.compare_exchange_strong(expected, expected & ~bit, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return false;
+    }
+
+    chunk->m_claimed.fetch_and(~uint32_t(bit), std::memory_order_release);
+
+    /* Point pushes at the hole we just made */
+    m_hint.store(chunk, std::memory_order_release);
+    return true;
+  }
+
+  /* Newest chunk */
+  alignas(64) std::atomic<Chunk*> m_head{};
+
+  /* Chunk that most recently had a free slot */
+  alignas(64) std::atomic<Chunk*> m_hint{};
+};
+
+} // namespace ut
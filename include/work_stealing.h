@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "lockfreelist.h"
+
+namespace ut {
+
+/* Unit of work for Work_stealing_pool. The submitter owns the task and must
+keep it alive until it has run. */
+struct Task : Node {
+  virtual void execute() = 0;
+};
+
+/* Worker threads that each own a Lock_free_list of tasks. The owner pushes
+and pops at the front, so nested spawns run LIFO and mostly hit a head no
+one else touches. An idle worker steals the back half of a random
+victim's list, the older tasks, which in fork/join code hold the bigger
+subtrees. The victim's front half stays in place: a steal only bumps the
+version of its head, the owner never sees its list empty and keeps
+popping in LIFO order. */
+struct Work_stealing_pool {
+  struct alignas(64) Worker {
+    Lock_free_list<Task> m_tasks;
+
+    Work_stealing_pool* m_pool{};
+
+    size_t m_id{};
+
+    /* xorshift state for picking victims */
+    uint64_t m_random{};
+
+    /* Tasks run by this worker and successful steals */
+    std::atomic<uint64_t> m_executed{};
+    std::atomic<uint64_t> m_steals{};
+  };
+
+  explicit Work_stealing_pool(size_t n_workers = std::thread::hardware_concurrency())
+    : m_n_workers(std::max<size_t>(1, n_workers)),
+      m_workers(std::make_unique<Worker[]>(m_n_workers)) {
+    for (size_t i = 0; i < m_n_workers; ++i) {
+      m_workers[i].m_pool = this;
+      m_workers[i].m_id = i;
+      m_workers[i].m_random = 0x9E3779B97F4A7C15ULL * (i + 1);
+    }
+
+    for (size_t i = 0; i < m_n_workers; ++i) {
+      m_threads.emplace_back([this, i]() { run(m_workers[i]); });
+    }
+  }
+
+  Work_stealing_pool(const Work_stealing_pool&) = delete;
+  Work_stealing_pool& operator=(const Work_stealing_pool&) = delete;
+
+  /* Tasks still queued are not run, they belong to their submitters */
+  ~Work_stealing_pool() {
+    m_stop.store(true, std::memory_order_release);
+
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  /* The worker the calling thread is, nullptr outside any pool */
+  static Worker*& current() noexcept {
+    thread_local Worker* worker{};
+
+    return worker;
+  }
+
+  /* Queue a task. From one of our workers it goes on that worker's own
+  list, from outside the workers are fed round robin. */
+  void submit(Task* task) {
+    if (auto self = current(); self != nullptr && self->m_pool == this) {
+      self->m_tasks.push_front(task);
+    } else {
+      m_workers[m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_n_workers].m_tasks.push_front(task);
+    }
+  }
+
+  /* Block until done() is true. A worker runs other tasks meanwhile, which
+  is what lets a task wait for the children it spawned. */
+  template <typename Done>
+  void wait_until(Done done) {
+    auto self = current();
+
+    while (!done()) {
+      if (self == nullptr || self->m_pool != this || !run_one(*self)) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /* Run one task from our own list or stolen, false if there was none */
+  bool run_one(Worker& self) {
+    auto task = static_cast<Task*>(self.m_tasks.pop_front());
+
+    if (task == nullptr) {
+      task = steal(self);
+    }
+
+    if (task == nullptr) {
+      return false;
+    }
+
+    task->execute();
+    self.m_executed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /* Try every other worker once, starting at a random one */
+  Task* steal(Worker& self) {
+    auto& x = self.m_random;
+
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    for (size_t i = 0; i < m_n_workers; ++i) {
+      auto& victim = m_workers[(x + i) % m_n_workers];
+
+      if (&victim == &self) {
+        continue;
+      }
+
+      if (auto task = steal_half(victim, self); task != nullptr) {
+        self.m_steals.fetch_add(1, std::memory_order_relaxed);
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  /* Take the back half of victim's tasks. The oldest one is returned to run
+  now, the rest go on the thief's own list. */
+  static Task* steal_half(Worker& victim, Worker& thief) {
+    auto [first, last] = victim.m_tasks.detach_back_half();
+
+    if (first == nullptr) {
+      return nullptr;
+    }
+
+    if (first != last) {
+      /* Only m_next is exact on a detached chain */
+      Node* rest_last = first;
+
+      while (rest_last->m_next.load(std::memory_order_relaxed) != last) {
+        rest_last = rest_last->m_next.load(std::memory_order_relaxed);
+      }
+
+      rest_last->m_next.store(rest_last->m_next.load(std::memory_order_relaxed).next_version().with_ptr(nullptr), std::memory_order_relaxed);
+      thief.m_tasks.splice_front(first, rest_last);
+    }
+
+    return static_cast<Task*>(last);
+  }
+
+  size_t worker_count() const noexcept {
+    return m_n_workers;
+  }
+
+  Worker& worker(size_t i) noexcept {
+    return m_workers[i];
+  }
+
+  void run(Worker& self) {
+    current() = &self;
+
+    while (!m_stop.load(std::memory_order_acquire)) {
+      if (!run_one(self)) {
+        std::this_thread::yield();
+      }
+    }
+
+    current() = nullptr;
+  }
+
+  const size_t m_n_workers;
+
+  std::unique_ptr<Worker[]> m_workers;
+
+  std::vector<std::thread> m_threads;
+
+  alignas(64) std::atomic<size_t> m_next_worker{};
+
+  std::atomic<bool> m_stop{};
+};
+
+} // namespace ut
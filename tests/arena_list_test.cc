@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "arena_list.h"
+
+TEST(ArenaList, HookIsTwelveBytes) {
+    using IntList = ut::Arena_list<int>;
+
+    EXPECT_EQ(sizeof(IntList::Arena_node), 16);
+    EXPECT_EQ(offsetof(IntList::Arena_node, m_value), 12);
+}
+
+TEST(ArenaList, PushIterateRemove) {
+    ut::Arena_list<int> list(100);
+    EXPECT_TRUE(list.empty());
+
+    std::vector<uint32_t> indexes;
+    for (int i = 0; i < 100; ++i) {
+        indexes.push_back(list.push_front(i));
+        ASSERT_NE(indexes.back(), list.null_index);
+    }
+
+    // Arena is full
+    EXPECT_EQ(list.push_front(100), list.null_index);
+
+    // push_front reverses the order
+    int expected = 99;
+    for (auto value : list) {
+        EXPECT_EQ(value, expected--);
+    }
+    EXPECT_EQ(expected, -1);
+
+    EXPECT_TRUE(list.remove(indexes[42]));
+    EXPECT_FALSE(list.remove(indexes[42]));
+    EXPECT_EQ(list.size(), 99);
+    EXPECT_EQ(list.find_if([](int v) { return v == 42; }), list.null_index);
+    EXPECT_EQ(list.find_if([](int v) { return v == 43; }), indexes[43]);
+
+    int out = -1;
+    EXPECT_TRUE(list.remove_if([](int v) { return v % 10 == 7; }, out));
+    EXPECT_EQ(out, 97);
+    EXPECT_EQ(list[indexes[43]], 43);
+
+    // Freed nodes go back to the arena
+    EXPECT_NE(list.push_front(100), list.null_index);
+    EXPECT_NE(list.push_front(101), list.null_index);
+    EXPECT_EQ(list.push_front(102), list.null_index);
+}
+
+TEST(ArenaList, RecycledIndexGetsNewVersion) {
+    ut::Arena_list<int> list(4);
+
+    const auto first = list.push_front(1);
+    const auto stale = list.m_nodes[0].m_next.load();
+
+    ASSERT_TRUE(list.remove(first));
+
+    // The free list is LIFO, so the same index comes back
+    const auto second = list.push_front(2);
+    ASSERT_EQ(second, first);
+
+    // The head names the same index again but a CAS with the old word fails
+    auto expected = stale;
+    EXPECT_EQ(list.index_of(expected), list.index_of(list.m_nodes[0].m_next.load()));
+    EXPECT_FALSE(list.m_nodes[0].m_next.compare_exchange_strong(expected, list.relink(stale, list.null_index)));
+    EXPECT_EQ(list.size(), 1);
+}
+
+TEST(ArenaList, IteratorSurvivesReleasedSuccessor) {
+    ut::Arena_list<int> list(5);
+    std::vector<uint32_t> indexes;
+
+    for (int i = 1; i <= 5; ++i) {
+        indexes.push_back(list.push_front(i));
+    }
+
+    // The successor goes back to the arena, its next word into the free list
+    auto it = list.begin();
+    ASSERT_EQ(*it, 5);
+    ASSERT_TRUE(list.remove(indexes[3]));
+
+    std::vector<int> rest(++it, list.end());
+    EXPECT_EQ(rest, std::vector<int>({3, 2, 1}));
+
+    // The successor comes back at the head, a new incarnation
+    it = list.begin();
+    ASSERT_EQ(*it, 5);
+    ASSERT_TRUE(list.remove(indexes[2]));
+    ASSERT_EQ(list.push_front(9), indexes[2]);
+
+    rest.assign(++it, list.end());
+    EXPECT_EQ(rest, std::vector<int>({2, 1}));
+
+    // Standing on a removed node starts over from the head
+    it = list.begin();
+    ASSERT_EQ(*it, 9);
+    ASSERT_TRUE(list.remove(it.index()));
+
+    rest.assign(++it, list.end());
+    EXPECT_EQ(rest, std::vector<int>({5, 2, 1}));
+}
+
+TEST(ArenaList, ConcurrentPushRemove) {
+    static const int NUM_THREADS = 4;
+    static const int ITEMS_PER_THREAD = 5000;
+
+    // Small arena so indexes are recycled all the time
+    ut::Arena_list<int> list(NUM_THREADS * 64);
+    std::vector<std::vector<int>> kept(NUM_THREADS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            // Index and value of what this thread has in the list
+            std::vector<std::pair<uint32_t, int>> mine;
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                const int value = t * ITEMS_PER_THREAD + i;
+                const auto index = list.push_front(value);
+                ASSERT_NE(index, list.null_index);
+                mine.emplace_back(index, value);
+
+                // Keep at most 32 values per thread in the list
+                if (mine.size() > 32) {
+                    ASSERT_TRUE(list.remove(mine.front().first));
+                    mine.erase(mine.begin());
+                }
+
+                if (i % 7 == 0) {
+                    int out;
+                    if (list.remove_if([t](int v) { return v / ITEMS_PER_THREAD == t && v % 2 == 1; }, out)) {
+                        auto it = std::find_if(mine.begin(), mine.end(), [&](const auto& entry) { return entry.second == out; });
+                        ASSERT_NE(it, mine.end());
+                        mine.erase(it);
+                    }
+                }
+            }
+            for (const auto& entry : mine) {
+                kept[t].push_back(entry.second);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> expected;
+    for (const auto& values : kept) {
+        expected.insert(expected.end(), values.begin(), values.end());
+    }
+    std::vector<int> actual(list.begin(), list.end());
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(actual, expected);
+}
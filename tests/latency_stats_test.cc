@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <sstream>
+
+#include "latency_stats.h"
+#include "tests/timestamp_node.h"
+
+using Latency_list = ut::Lock_free_list<DataNode, ut::Concurrency::MPMC, ut::Latency_stats<4>>;
+
+TEST(LatencyBuckets, BucketsCoverValues) {
+    using B = ut::Latency_buckets;
+
+    // Exact below 2 * sub_buckets, contiguous and within 1/sub_buckets above
+    for (uint64_t v = 0; v < 2 * B::sub_buckets; ++v) {
+        EXPECT_EQ(B::index(v), v);
+    }
+    for (size_t i = 0; i + 1 < B::n_buckets; ++i) {
+        EXPECT_EQ(B::index(B::lower_bound(i)), i);
+        EXPECT_EQ(B::index(B::upper_bound(i)), i);
+        EXPECT_EQ(B::upper_bound(i) + 1, B::lower_bound(i + 1));
+        EXPECT_LE(B::upper_bound(i) - B::lower_bound(i), B::lower_bound(i) / B::sub_buckets);
+    }
+    EXPECT_EQ(B::index(UINT64_MAX), B::n_buckets - 1);
+}
+
+TEST(LatencyHistogram, Percentiles) {
+    ut::Latency_stats<2> stats;
+
+    // 1..1000ns once each, plus one 1ms outlier
+    for (uint64_t ns = 1; ns <= 1000; ++ns) {
+        stats.record(ut::List_op::push_back, ns);
+    }
+    stats.record(ut::List_op::push_back, 1000000);
+
+    auto histogram = stats.histogram(ut::List_op::push_back);
+    auto summary = histogram.summary();
+    EXPECT_EQ(summary.m_count, 1001u);
+    EXPECT_EQ(summary.m_max, 1000000u);
+
+    // Within the bucket width of the exact rank
+    EXPECT_GE(summary.m_p50, 501u);
+    EXPECT_LE(summary.m_p50, 501u + 501u / ut::Latency_buckets::sub_buckets);
+    EXPECT_GE(summary.m_p99, 991u);
+    EXPECT_LE(summary.m_p99, 991u + 991u / ut::Latency_buckets::sub_buckets);
+    EXPECT_EQ(histogram.percentile(1.0), 1000000u);
+
+    EXPECT_EQ(stats.histogram(ut::List_op::remove).count(), 0u);
+    stats.reset();
+    EXPECT_EQ(stats.histogram(ut::List_op::push_back).count(), 0u);
+
+    std::ostringstream out;
+    out << summary;
+    EXPECT_NE(out.str().find("p99.9="), std::string::npos);
+}
+
+TEST(LatencyStats, ShardsAllocatedOnFirstRecord) {
+    ut::Latency_stats<8> stats;
+    EXPECT_EQ(stats.allocated_shards(), 0u);
+    EXPECT_EQ(stats.histogram(ut::List_op::push_back).count(), 0u);
+    stats.reset();
+
+    stats.record(ut::List_op::push_back, 10);
+    stats.record(ut::List_op::pop_front, 20);
+    EXPECT_EQ(stats.allocated_shards(), 1u);
+
+    std::thread([&stats] { stats.record(ut::List_op::push_back, 30); }).join();
+    EXPECT_LE(stats.allocated_shards(), 2u);
+    EXPECT_EQ(stats.histogram(ut::List_op::push_back).count(), 2u);
+    EXPECT_EQ(stats.histogram(ut::List_op::push_back).m_max, 30u);
+}
+
+TEST(LatencyHistogram, RecordAndMerge) {
+    ut::Latency_histogram a;
+    ut::Latency_histogram b;
+
+    for (uint64_t ns = 1; ns <= 100; ++ns) {
+        a.record(ns);
+    }
+    b.record(5000);
+
+    a += b;
+    EXPECT_EQ(a.count(), 101u);
+    EXPECT_EQ(a.m_max, 5000u);
+    EXPECT_EQ(a.percentile(1.0), 5000u);
+    EXPECT_LE(a.percentile(0.5), 51u + 51u / ut::Latency_buckets::sub_buckets);
+}
+
+TEST(LatencyStats, RecordsListOperations) {
+    Latency_list list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < 10; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        list.push_back(nodes[i].get());
+    }
+    list.push_front(nodes[8].get());
+    list.insert_after(nodes[0].get(), nodes[9].get());
+    list.remove(nodes[9].get());
+    list.find_if([](const DataNode* node) { return node->m_value == 100; });
+    list.pop_front();
+
+    EXPECT_EQ(ut::latencies(list, ut::List_op::push_back).count(), 8u);
+    EXPECT_EQ(ut::latencies(list, ut::List_op::push_front).count(), 1u);
+    EXPECT_EQ(ut::latencies(list, ut::List_op::insert_after).count(), 1u);
+    EXPECT_EQ(ut::latencies(list, ut::List_op::remove).count(), 1u);
+    EXPECT_EQ(ut::latencies(list, ut::List_op::find_if).count(), 1u);
+    EXPECT_EQ(ut::latencies(list, ut::List_op::pop_front).count(), 1u);
+    EXPECT_GT(ut::latencies(list, ut::List_op::push_back).m_max, 0u);
+
+    list.reset_stats();
+    EXPECT_EQ(ut::latencies(list, ut::List_op::push_back).count(), 0u);
+}
+
+TEST(LatencyStats, MergesThreads) {
+    static const int NUM_THREADS = 8;
+    static const int ITEMS_PER_THREAD = 5000;
+
+    Latency_list list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list.push_back(nodes[t * ITEMS_PER_THREAD + i].get());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto summary = ut::latencies(list, ut::List_op::push_back).summary();
+    EXPECT_EQ(summary.m_count, NUM_THREADS * ITEMS_PER_THREAD);
+    EXPECT_LE(summary.m_p50, summary.m_p99);
+    EXPECT_LE(summary.m_p99, summary.m_p999);
+    EXPECT_LE(summary.m_p999, summary.m_max);
+}
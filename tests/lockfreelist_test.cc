@@ -3,16 +3,24 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <numeric>
+#include <coroutine>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <sys/epoll.h>
+#include <unistd.h>
 
 #include "tests/timestamp_node.h"
 
-class LockFreeListTest : public ::testing::Test {
+template <typename List>
+class List_fixture : public ::testing::Test {
 protected:
-    std::unique_ptr<ut::Lock_free_list<DataNode>> list;
+    std::unique_ptr<List> list;
     std::vector<std::unique_ptr<DataNode>> nodes;
 
     void SetUp() override {
-        list = std::make_unique<ut::Lock_free_list<DataNode>>();
+        list = std::make_unique<List>();
     }
 
     void TearDown() override {
@@ -29,6 +37,11 @@ protected:
     }
 };
 
+class LockFreeListTest : public List_fixture<ut::Lock_free_list<DataNode>> {};
+
+// For pop_front_wait(), next() and the eventfd
+class BlockingListTest : public List_fixture<ut::Blocking_list<DataNode>> {};
+
 // Basic functionality tests
 TEST_F(LockFreeListTest, EmptyListIsEmpty) {
     std::vector<int> values;
@@ -239,6 +252,26 @@ TEST_F(LockFreeListTest, FindWithPredicate) {
     EXPECT_EQ(static_cast<DataNode*>(found)->m_value, 2);
 }
 
+// Links to a node carry different versions from each side, find_if must
+// validate a match by the node pointers alone
+TEST_F(LockFreeListTest, FindAfterLinkVersionsChange) {
+    for (int i = 0; i < 6; ++i) {
+        list->push_back(createNode(i));
+    }
+    list->remove(nodes[2].get());
+    list->remove(nodes[0].get());
+    list->push_front(createNode(6));
+    list->insert_after(nodes[3].get(), createNode(7));
+
+    for (int value : {6, 1, 3, 7, 4, 5}) {
+        auto found = list->find(value);
+        ASSERT_NE(found, nullptr) << value;
+        EXPECT_EQ(static_cast<DataNode*>((ut::Node*)found)->m_value, value);
+    }
+    EXPECT_EQ(list->find(0), nullptr);
+    EXPECT_EQ(list->find(2), nullptr);
+}
+
 TEST_F(LockFreeListTest, InsertAfterMiddle) {
     auto n1 = createNode(1);
     auto n2 = createNode(2);
@@ -681,3 +714,1335 @@ TEST_F(LockFreeListTest, STLAlgorithms) {
     EXPECT_EQ(count, 2);
 }
 
+
+TEST(AccessCounters, ShardedCountsExactly) {
+    ShardedTimestampNode node(1);
+    static const int NUM_THREADS = 4;
+    static const int ACCESSES_PER_THREAD = 10000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&node]() {
+            for (int i = 0; i < ACCESSES_PER_THREAD; ++i) {
+                node.record_access();
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(node.get_access_count(), NUM_THREADS * ACCESSES_PER_THREAD);
+
+    node.decay_access_count();
+    EXPECT_EQ(node.get_access_count(), NUM_THREADS * ACCESSES_PER_THREAD / 2);
+
+    node.reset_access_count();
+    EXPECT_EQ(node.get_access_count(), 0);
+}
+
+TEST(AccessCounters, MorrisEstimateAndDecay) {
+    MorrisTimestampNode node(1);
+    static const int ACCESSES = 100000;
+
+    for (int i = 0; i < ACCESSES; ++i) {
+        node.record_access();
+    }
+
+    auto estimate = node.get_access_count();
+    EXPECT_GT(estimate, ACCESSES / 2);
+    EXPECT_LT(estimate, ACCESSES * 2);
+
+    node.decay_access_count();
+    auto decayed = node.get_access_count();
+    EXPECT_LT(decayed, estimate);
+    EXPECT_NEAR(double(decayed), estimate / 2.0, estimate * 0.1);
+
+    node.decay_access_count(64);
+    EXPECT_EQ(node.get_access_count(), 0);
+}
+
+TEST(AccessCounters, LeastFrequentAfterDecay) {
+    ut::Lock_free_list<TimestampNode> list;
+    std::vector<std::unique_ptr<TimestampNode>> nodes;
+
+    for (int i = 0; i < 4; ++i) {
+        nodes.push_back(std::make_unique<TimestampNode>(i));
+        list.push_back(nodes.back().get());
+        for (int j = 0; j < (i + 1) * 10; ++j) {
+            nodes.back()->record_access();
+        }
+    }
+    nodes[2]->reset_access_count();
+
+    auto victim = node_utils::find_least_frequent(list.begin(), list.end());
+    ASSERT_NE(victim, list.end());
+    EXPECT_EQ(victim->m_value, 2);
+
+    node_utils::decay_access_counts(list.begin(), list.end());
+    EXPECT_EQ(nodes[3]->get_access_count(), 20);
+    EXPECT_EQ(nodes[0]->get_access_count(), 5);
+}
+
+TEST_F(LockFreeListTest, ParallelForEachVisitsEveryNode) {
+    static const int NUM_NODES = 10000;
+
+    for (int i = 0; i < NUM_NODES; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    std::vector<std::atomic<int>> visits(NUM_NODES);
+    ut::parallel_for_each(*list, [&visits](DataNode& node) {
+        visits[node.m_value].fetch_add(1, std::memory_order_relaxed);
+    }, 4, 64);
+
+    for (int i = 0; i < NUM_NODES; ++i) {
+        EXPECT_EQ(visits[i].load(), 1) << "node " << i;
+    }
+}
+
+TEST_F(LockFreeListTest, ParallelReduceSumsValues) {
+    static const int NUM_NODES = 5000;
+
+    for (int i = 0; i < NUM_NODES; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    auto sum = ut::parallel_reduce(*list, int64_t{0},
+        [](const DataNode& node) { return int64_t{node.m_value}; },
+        [](int64_t lhs, int64_t rhs) { return lhs + rhs; },
+        3, 100);
+
+    EXPECT_EQ(sum, int64_t{NUM_NODES} * (NUM_NODES - 1) / 2);
+
+    ut::Lock_free_list<DataNode> empty_list;
+    EXPECT_EQ(ut::parallel_reduce(empty_list, 0, [](const DataNode&) { return 1; }, std::plus<int>(), 2), 0);
+}
+
+TEST_F(LockFreeListTest, ParallelReducePropagatesExceptions) {
+    for (int i = 0; i < 1000; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    // The accumulators hold strings so a leak would show under ASan
+    auto reduce = [this]() {
+        return ut::parallel_reduce(*list, std::string{},
+            [](const DataNode& node) {
+                if (node.m_value == 777) {
+                    throw std::runtime_error("map failed");
+                }
+                return std::string(32, 'x');
+            },
+            [](std::string lhs, const std::string& rhs) { return lhs.size() > 64 ? lhs : lhs + rhs; },
+            4, 10);
+    };
+
+    EXPECT_THROW(reduce(), std::runtime_error);
+}
+
+TEST_F(IteratorBasics, ParallelAverageAge) {
+    auto serial = node_utils::average_age_seconds(list.begin(), list.end());
+    auto parallel = node_utils::parallel_average_age_seconds(list, 2);
+
+    EXPECT_GT(parallel, 0.0);
+    EXPECT_NEAR(parallel, serial, 0.1);
+}
+
+TEST_F(LockFreeListTest, PrefetchIteratorMatchesIterator) {
+    for (int i = 0; i < 100; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    auto collect = [this](auto range) {
+        std::vector<int> values;
+        for (const auto& node : range) {
+            values.push_back(node.m_value);
+        }
+        return values;
+    };
+
+    std::vector<int> expected;
+    for (const auto& node : *list) {
+        expected.push_back(node.m_value);
+    }
+
+    EXPECT_EQ(collect(list->prefetched<1>()), expected);
+    EXPECT_EQ(collect(list->prefetched<8>()), expected);
+    EXPECT_EQ(collect(list->prefetched<128>()), expected);
+
+    ut::Lock_free_list<DataNode> empty_list;
+    EXPECT_TRUE(collect(empty_list.prefetched()).empty());
+}
+
+TEST_F(LockFreeListTest, PrefetchIteratorSeesAppendAtEnd) {
+    list->push_back(createNode(1));
+    list->push_back(createNode(2));
+
+    auto range = list->prefetched<4>();
+    auto it = range.begin();
+    EXPECT_EQ(it->m_value, 1);
+
+    list->push_back(createNode(3));
+
+    std::vector<int> values;
+    for (; it != range.end(); ++it) {
+        values.push_back(it->m_value);
+    }
+    EXPECT_EQ(values, std::vector<int>({1, 2, 3}));
+}
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    using ListType = ut::Lock_free_list<VersionedDataNode>;
+    ListType list;
+    std::vector<std::unique_ptr<VersionedDataNode>> nodes;
+
+    VersionedDataNode* createNode(int value) {
+        nodes.push_back(std::make_unique<VersionedDataNode>(value));
+        return nodes.back().get();
+    }
+
+    template<typename Range>
+    static std::vector<int> values(const Range& range) {
+        std::vector<int> result;
+        for (const auto& node : range) {
+            result.push_back(node.m_value);
+        }
+        return result;
+    }
+};
+
+TEST_F(SnapshotTest, IgnoresLaterInserts) {
+    list.push_back(createNode(1));
+    list.push_back(createNode(2));
+
+    auto snapshot = list.take_snapshot();
+
+    list.push_front(createNode(0));
+    list.push_back(createNode(3));
+    list.insert_after(nodes[0].get(), createNode(4));
+
+    EXPECT_EQ(values(snapshot), std::vector<int>({1, 2}));
+    EXPECT_EQ(values(list), std::vector<int>({0, 1, 4, 2, 3}));
+}
+
+TEST_F(SnapshotTest, SeesLaterRemovesUntilClosed) {
+    for (int i = 0; i < 5; ++i) {
+        list.push_back(createNode(i));
+    }
+
+    {
+        auto snapshot = list.take_snapshot();
+
+        list.remove(nodes[1].get());
+        list.remove(nodes[3].get());
+
+        EXPECT_EQ(values(snapshot), std::vector<int>({0, 1, 2, 3, 4}));
+        EXPECT_TRUE(nodes[1]->is_removed());
+        EXPECT_FALSE(nodes[1]->is_unlinked());
+        EXPECT_EQ(list.find(1), nullptr);
+
+        auto later = list.take_snapshot();
+        EXPECT_EQ(values(later), std::vector<int>({0, 2, 4}));
+    }
+
+    EXPECT_EQ(list.snapshots_active(), 0u);
+    EXPECT_TRUE(nodes[1]->is_unlinked());
+    EXPECT_TRUE(nodes[3]->is_unlinked());
+    EXPECT_EQ(values(list), std::vector<int>({0, 2, 4}));
+}
+
+TEST_F(SnapshotTest, CountsNodesLeftForTheSweep) {
+    for (int i = 0; i < 3; ++i) {
+        list.push_back(createNode(i));
+    }
+
+    {
+        auto snapshot = list.take_snapshot();
+
+        EXPECT_EQ(list.retired_pending(), 0u);
+        list.remove(nodes[1].get());
+        EXPECT_EQ(list.retired_pending(), 1u);
+    }
+
+    EXPECT_EQ(list.retired_pending(), 0u);
+    EXPECT_TRUE(nodes[1]->is_unlinked());
+
+    list.remove(nodes[0].get());
+
+    EXPECT_EQ(list.retired_pending(), 0u);
+    EXPECT_TRUE(nodes[0]->is_unlinked());
+    EXPECT_EQ(values(list), std::vector<int>({2}));
+}
+
+TEST_F(SnapshotTest, RemoveWithoutSnapshotUnlinks) {
+    list.push_back(createNode(1));
+    list.push_back(createNode(2));
+
+    list.remove(nodes[0].get());
+
+    EXPECT_TRUE(nodes[0]->is_unlinked());
+    EXPECT_EQ(values(list), std::vector<int>({2}));
+}
+
+TEST_F(SnapshotTest, ConsistentUnderConcurrentWriters) {
+    static const int NUM_STABLE = 64;
+
+    std::vector<VersionedDataNode*> stable;
+    for (int i = 0; i < NUM_STABLE; ++i) {
+        stable.push_back(createNode(i * 2));
+        list.push_back(stable.back());
+    }
+
+    std::vector<std::unique_ptr<VersionedDataNode>> scratch;
+    for (int i = 0; i < 2000; ++i) {
+        scratch.push_back(std::make_unique<VersionedDataNode>(-1));
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread writer([&]() {
+        size_t next = 0;
+        std::vector<VersionedDataNode*> live;
+        std::mt19937 gen(7);
+        while (!stop.load() && next < scratch.size()) {
+            if (live.empty() || gen() % 2 == 0) {
+                auto node = scratch[next++].get();
+                list.insert_after(stable[gen() % NUM_STABLE], node);
+                live.push_back(node);
+            } else {
+                list.remove(live.back());
+                live.pop_back();
+            }
+        }
+    });
+
+    for (int i = 0; i < 50; ++i) {
+        auto snapshot = list.take_snapshot();
+        auto first = values(snapshot);
+        auto second = values(snapshot);
+
+        // Every pass over the same snapshot sees exactly the same nodes
+        EXPECT_EQ(first, second);
+
+        std::vector<int> stable_seen;
+        std::copy_if(first.begin(), first.end(), std::back_inserter(stable_seen), [](int v) { return v >= 0; });
+        ASSERT_EQ(stable_seen.size(), NUM_STABLE);
+        EXPECT_TRUE(std::is_sorted(stable_seen.begin(), stable_seen.end()));
+    }
+
+    stop.store(true);
+    writer.join();
+}
+
+// Snapshots open and close on several threads, so the last one to close
+// sweeps while others are opening, and inserts race with the epoch they
+// are stamped at
+TEST_F(SnapshotTest, ConsistentWithOverlappingSnapshots) {
+    static const int NUM_STABLE = 32;
+    static const int NUM_READERS = 3;
+
+    std::vector<VersionedDataNode*> stable;
+    for (int i = 0; i < NUM_STABLE; ++i) {
+        stable.push_back(createNode(i * 2));
+        list.push_back(stable.back());
+    }
+
+    std::vector<std::unique_ptr<VersionedDataNode>> scratch;
+    for (int i = 0; i < 20000; ++i) {
+        scratch.push_back(std::make_unique<VersionedDataNode>(-1));
+    }
+
+    std::atomic<int> readers_done{0};
+    std::thread writer([&]() {
+        size_t next = 0;
+        std::vector<VersionedDataNode*> live;
+        std::mt19937 gen(11);
+        while (readers_done.load() < NUM_READERS && next < scratch.size()) {
+            if (live.size() < 64 && gen() % 2 == 0) {
+                auto node = scratch[next++].get();
+                if (gen() % 2 == 0) {
+                    list.push_front(node);
+                } else {
+                    list.insert_after(stable[gen() % NUM_STABLE], node);
+                }
+                live.push_back(node);
+            } else if (!live.empty()) {
+                auto i = gen() % live.size();
+                list.remove(live[i]);
+                live[i] = live.back();
+                live.pop_back();
+            }
+        }
+    });
+
+    std::vector<std::thread> readers;
+    std::atomic<int> mismatches{0};
+    for (int r = 0; r < NUM_READERS; ++r) {
+        readers.emplace_back([&]() {
+            for (int i = 0; i < 200; ++i) {
+                auto snapshot = list.take_snapshot();
+                auto first = values(snapshot);
+                std::this_thread::yield();
+                auto second = values(snapshot);
+
+                mismatches += first != second;
+                mismatches += std::count_if(first.begin(), first.end(), [](int v) { return v >= 0; }) != NUM_STABLE;
+            }
+            readers_done.fetch_add(1);
+        });
+    }
+
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    writer.join();
+
+    EXPECT_EQ(mismatches.load(), 0);
+    EXPECT_EQ(list.snapshots_active(), 0u);
+}
+
+TEST_F(LockFreeListTest, GatherProjectsIntoSpan) {
+    for (int i = 0; i < 10; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    std::array<int, 4> small{};
+    EXPECT_EQ(ut::gather(*list, std::span<int>(small), [](const DataNode& node) { return node.m_value * 10; }), 4u);
+    EXPECT_EQ(small, (std::array<int, 4>{0, 10, 20, 30}));
+
+    std::vector<int> large(16, -1);
+    EXPECT_EQ(ut::gather(*list, std::span<int>(large), [](const DataNode& node) { return node.m_value; }), 10u);
+    EXPECT_EQ(large[9], 9);
+    EXPECT_EQ(large[10], -1);
+}
+
+TEST_F(LockFreeListTest, ForEachChunkCoversList) {
+    static const int NUM_NODES = 1000;
+
+    for (int i = 0; i < NUM_NODES; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    std::array<int64_t, 64> buffer;
+    int64_t sum = 0;
+    size_t chunks = 0;
+    size_t count = 0;
+
+    ut::for_each_chunk(*list, std::span<int64_t>(buffer), [](const DataNode& node) { return int64_t{node.m_value}; },
+        [&](std::span<const int64_t> chunk) {
+            ++chunks;
+            count += chunk.size();
+            sum = std::accumulate(chunk.begin(), chunk.end(), sum);
+        });
+
+    EXPECT_EQ(count, NUM_NODES);
+    EXPECT_EQ(chunks, (NUM_NODES + buffer.size() - 1) / buffer.size());
+    EXPECT_EQ(sum, int64_t{NUM_NODES} * (NUM_NODES - 1) / 2);
+}
+
+TEST_F(LockFreeListTest, ForEachChunkRejectsEmptyBuffer) {
+    list->push_back(createNode(1));
+
+    std::span<int> buffer;
+    EXPECT_THROW(ut::for_each_chunk(*list, buffer, [](const DataNode& node) { return node.m_value; },
+                                    [](std::span<const int>) {}),
+                 std::invalid_argument);
+}
+
+TEST_F(LockFreeListTest, PopFrontInOrder) {
+    EXPECT_EQ(list->pop_front(), nullptr);
+
+    for (int i = 0; i < 5; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        auto node = static_cast<DataNode*>(list->pop_front());
+        ASSERT_NE(node, nullptr);
+        EXPECT_EQ(node->m_value, i);
+    }
+    EXPECT_EQ(list->pop_front(), nullptr);
+    EXPECT_EQ(list->m_tail.load(), nullptr);
+
+    // The emptied list takes new nodes at both ends
+    list->push_back(createNode(10));
+    list->push_front(createNode(9));
+    std::vector<int> values;
+    for (const auto& node : *list) {
+        values.push_back(node.m_value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{9, 10}));
+}
+
+TEST_F(LockFreeListTest, RemoveTailThenPopFront) {
+    auto a = createNode(1);
+    auto b = createNode(2);
+    list->push_back(a);
+    list->push_back(b);
+
+    // Removing the last node moves the tail back to a
+    list->remove(b);
+    EXPECT_EQ(static_cast<ut::Node*>(list->m_tail.load()), static_cast<ut::Node*>(a));
+    EXPECT_EQ(list->pop_front(), a);
+    EXPECT_EQ(list->pop_front(), nullptr);
+
+    // And the only node empties the list
+    list->push_back(b);
+    list->remove(b);
+    EXPECT_EQ(list->m_head.load(), nullptr);
+    EXPECT_EQ(list->m_tail.load(), nullptr);
+
+    auto c = createNode(3);
+    list->push_back(a);
+    list->push_back(b);
+    list->remove(b);
+    list->push_back(c);
+    std::vector<int> values;
+    for (const auto& node : *list) {
+        values.push_back(node.m_value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{1, 3}));
+    EXPECT_EQ(list->pop_front(), a);
+    EXPECT_EQ(list->pop_front(), c);
+    EXPECT_EQ(list->pop_front(), nullptr);
+}
+
+TEST_F(LockFreeListTest, ConcurrentPushBackAndPopFrontStress) {
+    static const int NUM_THREADS = 4;
+    static const int ITEMS_PER_THREAD = 20000;
+
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        createNode(i);
+    }
+
+    // Every thread appends and pops, so pops race with tails not yet moved
+    std::vector<std::vector<int>> popped(NUM_THREADS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([this, &popped, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list->push_back(nodes[t * ITEMS_PER_THREAD + i].get());
+                if (i % 2 == 1) {
+                    for (int j = 0; j < 2; ++j) {
+                        if (auto node = list->pop_front()) {
+                            popped[t].push_back(static_cast<DataNode*>(node)->m_value);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    for (const auto& v : popped) {
+        values.insert(values.end(), v.begin(), v.end());
+    }
+    while (auto node = list->pop_front()) {
+        values.push_back(static_cast<DataNode*>(node)->m_value);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), NUM_THREADS * ITEMS_PER_THREAD);
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(list->m_tail.load(), nullptr);
+}
+
+TEST_F(LockFreeListTest, ConcurrentPopFrontAndPush) {
+    static const int NUM_PRODUCERS = 2;
+    static const int NUM_CONSUMERS = 2;
+    static const int ITEMS_PER_PRODUCER = 5000;
+
+    for (int i = 0; i < NUM_PRODUCERS * ITEMS_PER_PRODUCER; ++i) {
+        createNode(i);
+    }
+
+    std::atomic<int> popped_count{0};
+    std::vector<std::vector<int>> popped(NUM_CONSUMERS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < NUM_PRODUCERS; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                auto node = nodes[t * ITEMS_PER_PRODUCER + i].get();
+                // Mix both ends so the last node races with push_front too
+                if (i % 4 == 0) {
+                    list->push_front(node);
+                } else {
+                    list->push_back(node);
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < NUM_CONSUMERS; ++t) {
+        threads.emplace_back([&, t]() {
+            while (popped_count.load() < NUM_PRODUCERS * ITEMS_PER_PRODUCER) {
+                if (auto node = list->pop_front()) {
+                    popped[t].push_back(static_cast<DataNode*>(node)->m_value);
+                    popped_count.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    for (const auto& v : popped) {
+        values.insert(values.end(), v.begin(), v.end());
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), NUM_PRODUCERS * ITEMS_PER_PRODUCER);
+    for (int i = 0; i < NUM_PRODUCERS * ITEMS_PER_PRODUCER; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(list->m_head.load(), nullptr);
+    EXPECT_EQ(list->m_tail.load(), nullptr);
+}
+
+TEST_F(LockFreeListTest, DetachAllAndSpliceFront) {
+    auto [empty_first, empty_last] = list->detach_all();
+    EXPECT_EQ(empty_first, nullptr);
+    EXPECT_EQ(empty_last, nullptr);
+
+    for (int i = 0; i < 4; ++i) {
+        list->push_back(createNode(i));
+    }
+
+    auto [first, last] = list->detach_all();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(static_cast<DataNode*>(first)->m_value, 0);
+    EXPECT_EQ(static_cast<DataNode*>(last)->m_value, 3);
+    EXPECT_EQ(list->m_head.load(), nullptr);
+    EXPECT_EQ(list->m_tail.load(), nullptr);
+
+    // Splice into an empty list sets the tail, into a non empty one keeps it
+    list->splice_front(first, last);
+    list->push_back(createNode(4));
+
+    ut::Lock_free_list<DataNode> other;
+    auto chain = createNode(-1);
+    other.splice_front(chain, chain);
+    auto [moved_first, moved_last] = list->detach_all();
+    other.splice_front(moved_first, moved_last);
+
+    std::vector<int> values;
+    for (const auto& node : other) {
+        values.push_back(node.m_value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3, 4, -1}));
+    EXPECT_EQ(other.m_tail.load(), chain);
+    EXPECT_EQ(static_cast<DataNode*>(other.pop_front())->m_value, 0);
+    other.clear();
+}
+
+TEST_F(LockFreeListTest, DetachBackHalfKeepsFront) {
+    auto [empty_first, empty_last] = list->detach_back_half();
+    EXPECT_EQ(empty_first, nullptr);
+    EXPECT_EQ(empty_last, nullptr);
+
+    for (int i = 0; i < 5; ++i) {
+        list->push_back(createNode(i));
+    }
+    auto head = list->m_head.load();
+
+    auto [first, last] = list->detach_back_half();
+    EXPECT_EQ(static_cast<DataNode*>(first)->m_value, 2);
+    EXPECT_EQ(static_cast<DataNode*>(last)->m_value, 4);
+    EXPECT_EQ((ut::Node*)list->m_head.load(), (ut::Node*)head);
+    EXPECT_EQ((ut::Node*)list->m_tail.load(), nodes[1].get());
+
+    // The tail moved back, appends go after the front half
+    list->push_back(createNode(5));
+
+    std::vector<int> values;
+    for (const auto& node : *list) {
+        values.push_back(node.m_value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 5}));
+}
+
+TEST_F(LockFreeListTest, ConcurrentDetachBackHalfAndFrontPops) {
+    static const int ITEMS = 50000;
+    static const int THIEVES = 2;
+
+    for (int i = 0; i < ITEMS; ++i) {
+        createNode(i);
+    }
+
+    // The owner pushes and pops at the front while thieves take the back
+    std::atomic<bool> done{false};
+    std::vector<std::vector<int>> taken(THIEVES + 1);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THIEVES; ++t) {
+        threads.emplace_back([this, &done, &taken, t]() {
+            while (!done.load()) {
+                auto [first, last] = list->detach_back_half();
+                for (ut::Node* node = first; node != nullptr; node = node == last ? nullptr : (ut::Node*)node->m_next.load()) {
+                    taken[t].push_back(static_cast<DataNode*>(node)->m_value);
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < ITEMS; ++i) {
+        list->push_front(nodes[i].get());
+        if (i % 3 == 2) {
+            if (auto node = list->pop_front()) {
+                taken[THIEVES].push_back(static_cast<DataNode*>(node)->m_value);
+            }
+        }
+        if (i % 64 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    done.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    for (const auto& v : taken) {
+        values.insert(values.end(), v.begin(), v.end());
+    }
+    while (auto node = list->pop_front()) {
+        values.push_back(static_cast<DataNode*>(node)->m_value);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), ITEMS);
+    for (int i = 0; i < ITEMS; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+template <typename List>
+class QueueModeTest : public ::testing::Test {};
+
+using QueueModes = ::testing::Types<
+    ut::Lock_free_list<DataNode, ut::Concurrency::SPSC>,
+    ut::Lock_free_list<DataNode, ut::Concurrency::MPSC>,
+    ut::Lock_free_list<DataNode, ut::Concurrency::SPMC>,
+    ut::Lock_free_list<DataNode, ut::Concurrency::MPMC>>;
+TYPED_TEST_SUITE(QueueModeTest, QueueModes);
+
+TYPED_TEST(QueueModeTest, FifoOrder) {
+    TypeParam list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+
+    for (int round = 0; round < 2; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            nodes.push_back(std::make_unique<DataNode>(i));
+            list.push_back(nodes.back().get());
+        }
+        for (int i = 0; i < 10; ++i) {
+            auto node = static_cast<DataNode*>(list.pop_front());
+            ASSERT_NE(node, nullptr);
+            EXPECT_EQ(node->m_value, i);
+        }
+        EXPECT_EQ(list.pop_front(), nullptr);
+        EXPECT_EQ(list.m_tail.load(), nullptr);
+    }
+}
+
+TYPED_TEST(QueueModeTest, WalkWithPrefetched) {
+    ut::Lock_free_list<DataNode, TypeParam::concurrency, ut::Contention_stats<>> list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+
+    for (int i = 0; i < 4; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+        list.push_back(nodes.back().get());
+    }
+
+    std::vector<int> values;
+    for (const auto& node : list.prefetched()) {
+        values.push_back(node.m_value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(list.stats().m_iterator_recoveries, 0u);
+
+    while (list.pop_front() != nullptr) {
+    }
+}
+
+TYPED_TEST(QueueModeTest, ConcurrentProducersConsumers) {
+    using List = TypeParam;
+    static const int ITEMS_PER_PRODUCER = 10000;
+
+    const ut::Concurrency mode = List::concurrency;
+    const int num_producers = mode == ut::Concurrency::SPSC || mode == ut::Concurrency::SPMC ? 1 : 3;
+    const int num_consumers = List::single_consumer ? 1 : 3;
+    const int total = num_producers * ITEMS_PER_PRODUCER;
+
+    List list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < total; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    std::atomic<int> popped_count{0};
+    std::vector<std::vector<int>> popped(num_consumers);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < num_producers; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                list.push_back(nodes[t * ITEMS_PER_PRODUCER + i].get());
+            }
+        });
+    }
+    for (int t = 0; t < num_consumers; ++t) {
+        threads.emplace_back([&, t]() {
+            while (popped_count.load() < total) {
+                if (auto node = list.pop_front()) {
+                    popped[t].push_back(static_cast<DataNode*>(node)->m_value);
+                    popped_count.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Each consumer sees every producer's values in push order
+    for (const auto& values : popped) {
+        std::vector<int> last(num_producers, -1);
+        for (auto value : values) {
+            EXPECT_GT(value, last[value / ITEMS_PER_PRODUCER]);
+            last[value / ITEMS_PER_PRODUCER] = value;
+        }
+    }
+
+    std::vector<int> all;
+    for (const auto& values : popped) {
+        all.insert(all.end(), values.begin(), values.end());
+    }
+    std::sort(all.begin(), all.end());
+    ASSERT_EQ(all.size(), total);
+    for (int i = 0; i < total; ++i) {
+        EXPECT_EQ(all[i], i);
+    }
+    EXPECT_EQ(list.pop_front(), nullptr);
+}
+
+TEST(MpscList, DrainInBatches) {
+    ut::Mpsc_list<DataNode> list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+
+    for (int i = 0; i < 10; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+        list.push_back(nodes.back().get());
+    }
+
+    std::vector<int> values;
+    auto collect = [&values](DataNode& node) { values.push_back(node.m_value); };
+
+    EXPECT_EQ(list.drain(collect, 4), 4);
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(list.drain(collect), 6);
+    EXPECT_EQ(values.size(), 10);
+    EXPECT_EQ(values.back(), 9);
+    EXPECT_EQ(list.drain(collect), 0);
+
+    // Nodes pushed again from inside fn are seen by the next drain
+    list.push_back(nodes[0].get());
+    EXPECT_EQ(list.drain([&list](DataNode& node) { list.push_back(&node); }), 1);
+    EXPECT_EQ(static_cast<DataNode*>(list.pop_front()), nodes[0].get());
+    EXPECT_EQ(list.pop_front(), nullptr);
+}
+
+TEST(MpscList, ConcurrentProducersDrainingConsumer) {
+    static const int NUM_PRODUCERS = 4;
+    static const int ITEMS_PER_PRODUCER = 10000;
+    static const int TOTAL = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    ut::Mpsc_list<DataNode> list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < TOTAL; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < NUM_PRODUCERS; ++t) {
+        producers.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                list.push_back(nodes[t * ITEMS_PER_PRODUCER + i].get());
+            }
+        });
+    }
+
+    std::vector<int> last(NUM_PRODUCERS, -1);
+    int drained = 0;
+    while (drained < TOTAL) {
+        drained += list.drain([&](DataNode& node) {
+            // Per producer FIFO
+            EXPECT_GT(node.m_value, last[node.m_value / ITEMS_PER_PRODUCER]);
+            last[node.m_value / ITEMS_PER_PRODUCER] = node.m_value;
+        }, 64);
+    }
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    EXPECT_EQ(drained, TOTAL);
+    for (int t = 0; t < NUM_PRODUCERS; ++t) {
+        EXPECT_EQ(last[t], (t + 1) * ITEMS_PER_PRODUCER - 1);
+    }
+}
+
+TEST_F(BlockingListTest, PopFrontWaitTimesOut) {
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(list->pop_front_wait(std::chrono::milliseconds(20)), nullptr);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+    EXPECT_EQ(list->m_waiters.load(), 0u);
+
+    // A non empty list returns without waiting
+    auto n1 = createNode(1);
+    list->push_back(n1);
+    EXPECT_EQ(list->pop_front_wait(std::chrono::seconds(10)), n1);
+}
+
+TEST_F(BlockingListTest, PopFrontWaitWokenByPush) {
+    auto n1 = createNode(1);
+
+    std::thread consumer([&]() {
+        EXPECT_EQ(list->pop_front_wait(std::chrono::seconds(30)), n1);
+    });
+
+    // Push only once the consumer is parked
+    while (list->m_waiters.load() == 0) {
+        std::this_thread::yield();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    list->push_back(n1);
+    consumer.join();
+
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(10));
+    EXPECT_EQ(list->m_waiters.load(), 0u);
+}
+
+TEST_F(BlockingListTest, ConcurrentPopFrontWait) {
+    static const int NUM_PRODUCERS = 2;
+    static const int NUM_CONSUMERS = 3;
+    static const int ITEMS_PER_PRODUCER = 2000;
+    static const int TOTAL = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    for (int i = 0; i < TOTAL; ++i) {
+        createNode(i);
+    }
+
+    std::atomic<int> popped_count{0};
+    std::vector<std::vector<int>> popped(NUM_CONSUMERS);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < NUM_CONSUMERS; ++t) {
+        threads.emplace_back([&, t]() {
+            while (popped_count.load() < TOTAL) {
+                if (auto node = list->pop_front_wait(std::chrono::milliseconds(10))) {
+                    popped[t].push_back(static_cast<DataNode*>(node)->m_value);
+                    popped_count.fetch_add(1);
+                }
+            }
+        });
+    }
+
+    for (int t = 0; t < NUM_PRODUCERS; ++t) {
+        threads.emplace_back([this, t]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                // Trickle so that the consumers keep parking
+                if (i % 100 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+                auto node = nodes[t * ITEMS_PER_PRODUCER + i].get();
+                if (i % 2 == 0) {
+                    list->push_front(node);
+                } else {
+                    list->push_back(node);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    for (const auto& v : popped) {
+        values.insert(values.end(), v.begin(), v.end());
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), TOTAL);
+    for (int i = 0; i < TOTAL; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(list->m_waiters.load(), 0u);
+}
+
+// Fire and forget coroutine, the frame is freed when it finishes
+struct Detached_task {
+    struct promise_type {
+        Detached_task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Keeps the handles so that the test decides where they resume
+struct Deferred_executor {
+    std::mutex* m_mutex;
+    std::vector<std::coroutine_handle<>>* m_handles;
+
+    void operator()(std::coroutine_handle<> handle) const {
+        std::lock_guard<std::mutex> lock(*m_mutex);
+        m_handles->push_back(handle);
+    }
+};
+
+TEST_F(BlockingListTest, NextReadyWithoutSuspending) {
+    auto n1 = createNode(1);
+    list->push_back(n1);
+
+    DataNode* got{};
+    [](ut::Blocking_list<DataNode>& list, DataNode*& got) -> Detached_task {
+        got = co_await list.next();
+    }(*list, got);
+
+    EXPECT_EQ(got, n1);
+    EXPECT_EQ(list->m_awaiters.load(), nullptr);
+}
+
+TEST_F(BlockingListTest, NextResumesOnExecutor) {
+    std::mutex mutex;
+    std::vector<std::coroutine_handle<>> handles;
+    std::vector<int> got;
+
+    auto consumer = [](ut::Blocking_list<DataNode>& list, Deferred_executor executor, std::vector<int>& got) -> Detached_task {
+        for (int i = 0; i < 2; ++i) {
+            got.push_back((co_await list.next(executor))->m_value);
+        }
+    };
+    consumer(*list, Deferred_executor{&mutex, &handles}, got);
+
+    EXPECT_TRUE(got.empty());
+    EXPECT_NE(list->m_awaiters.load(), nullptr);
+
+    // The push pops for the waiter and hands it to the executor
+    list->push_back(createNode(1));
+    ASSERT_EQ(handles.size(), 1u);
+    EXPECT_EQ(list->m_awaiters.load(), nullptr);
+    EXPECT_EQ(list->pop_front(), nullptr);
+    EXPECT_TRUE(got.empty());
+
+    handles.back().resume();
+    EXPECT_EQ(got, (std::vector<int>{1}));
+
+    // Parked again until the next push
+    list->push_back(createNode(2));
+    ASSERT_EQ(handles.size(), 2u);
+    handles.back().resume();
+    EXPECT_EQ(got, (std::vector<int>{1, 2}));
+    EXPECT_EQ(list->m_awaiters.load(), nullptr);
+}
+
+TEST_F(BlockingListTest, NextQueuesOnListByDefault) {
+    std::vector<int> got;
+    auto consumer = [](ut::Blocking_list<DataNode>& list, std::vector<int>& got) -> Detached_task {
+        for (int i = 0; i < 2; ++i) {
+            got.push_back((co_await list.next())->m_value);
+        }
+    };
+    consumer(*list, got);
+
+    // The push pops for the waiter but leaves it queued on the list
+    list->push_back(createNode(1));
+    EXPECT_EQ(list->m_awaiters.load(), nullptr);
+    EXPECT_NE(list->m_woken.load(), nullptr);
+    EXPECT_TRUE(got.empty());
+
+    EXPECT_EQ(list->resume_woken(), 1u);
+    EXPECT_EQ(got, (std::vector<int>{1}));
+    EXPECT_EQ(list->resume_woken(), 0u);
+
+    list->push_back(createNode(2));
+    EXPECT_EQ(list->resume_woken(), 1u);
+    EXPECT_EQ(got, (std::vector<int>{1, 2}));
+}
+
+TEST_F(BlockingListTest, NextInlineExecutorResumesInPush) {
+    std::vector<int> got;
+    auto consumer = [](ut::Blocking_list<DataNode>& list, std::vector<int>& got) -> Detached_task {
+        got.push_back((co_await list.next(ut::Inline_executor{}))->m_value);
+    };
+    consumer(*list, got);
+
+    list->push_back(createNode(1));
+    EXPECT_EQ(got, (std::vector<int>{1}));
+    EXPECT_EQ(list->m_woken.load(), nullptr);
+}
+
+TEST_F(BlockingListTest, ConcurrentNextAwaiters) {
+    static const int NUM_PRODUCERS = 3;
+    static const int NUM_COROUTINES = 8;
+    static const int ITEMS_PER_PRODUCER = 4000;
+    static const int TOTAL = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    for (int i = 0; i < TOTAL; ++i) {
+        createNode(i);
+    }
+
+    std::vector<std::vector<int>> popped(NUM_COROUTINES);
+    std::atomic<int> finished{0};
+
+    // Each coroutine takes an equal share, woken by whichever producer
+    // popped for it and resumed on the main thread
+    auto consumer = [](ut::Blocking_list<DataNode>& list, std::vector<int>& popped, std::atomic<int>& finished) -> Detached_task {
+        for (int i = 0; i < TOTAL / NUM_COROUTINES; ++i) {
+            popped.push_back((co_await list.next())->m_value);
+        }
+        finished.fetch_add(1);
+    };
+    for (int t = 0; t < NUM_COROUTINES; ++t) {
+        consumer(*list, popped[t], finished);
+    }
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < NUM_PRODUCERS; ++t) {
+        producers.emplace_back([this, t]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                auto node = nodes[t * ITEMS_PER_PRODUCER + i].get();
+                if (i % 2 == 0) {
+                    list->push_front(node);
+                } else {
+                    list->push_back(node);
+                }
+            }
+        });
+    }
+    while (finished.load() < NUM_COROUTINES) {
+        if (list->resume_woken() == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+
+    EXPECT_EQ(list->m_woken.load(), nullptr);
+    std::vector<int> values;
+    for (const auto& v : popped) {
+        values.insert(values.end(), v.begin(), v.end());
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), TOTAL);
+    for (int i = 0; i < TOTAL; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_EQ(list->pop_front(), nullptr);
+    EXPECT_EQ(list->m_awaiters.load(), nullptr);
+}
+
+// Counter value of the eventfd, 0 if it is not readable
+static uint64_t read_eventfd(int fd) {
+    uint64_t count{};
+    return ::read(fd, &count, sizeof(count)) == sizeof(count) ? count : 0;
+}
+
+TEST_F(BlockingListTest, EventfdCoalescesSignals) {
+    list->push_back(createNode(0));
+
+    const int fd = list->open_eventfd();
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(list->event_fd(), fd);
+
+    // The node pushed before the fd was attached signals at once
+    EXPECT_EQ(read_eventfd(fd), 1u);
+
+    // A burst costs one write until the consumer rearms
+    for (int i = 1; i < 5; ++i) {
+        list->push_back(createNode(i));
+    }
+    EXPECT_EQ(read_eventfd(fd), 0u);
+
+    // Rearming a non empty list tells the caller to keep draining
+    EXPECT_FALSE(list->rearm_eventfd());
+    while (list->pop_front() != nullptr) {
+    }
+    EXPECT_TRUE(list->rearm_eventfd());
+
+    list->push_front(createNode(5));
+    list->push_back(createNode(6));
+    EXPECT_EQ(read_eventfd(fd), 1u);
+}
+
+TEST_F(BlockingListTest, EventfdEpollConsumer) {
+    static const int NUM_PRODUCERS = 2;
+    static const int ITEMS_PER_PRODUCER = 5000;
+    static const int TOTAL = NUM_PRODUCERS * ITEMS_PER_PRODUCER;
+
+    for (int i = 0; i < TOTAL; ++i) {
+        createNode(i);
+    }
+
+    const int fd = list->open_eventfd();
+    ASSERT_GE(fd, 0);
+    const int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    ASSERT_GE(epfd, 0);
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ASSERT_EQ(::epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev), 0);
+
+    std::vector<std::thread> producers;
+    for (int t = 0; t < NUM_PRODUCERS; ++t) {
+        producers.emplace_back([this, t]() {
+            for (int i = 0; i < ITEMS_PER_PRODUCER; ++i) {
+                if (i % 500 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                list->push_back(nodes[t * ITEMS_PER_PRODUCER + i].get());
+            }
+        });
+    }
+
+    // Event loop: wait for the fd, drain in batches of 64, rearm when empty
+    std::vector<int> values;
+    int wakeups = 0;
+    while (values.size() < TOTAL) {
+        epoll_event out{};
+        ASSERT_EQ(::epoll_wait(epfd, &out, 1, 10000), 1);
+        ++wakeups;
+
+        do {
+            for (int batch = 0; batch < 64; ++batch) {
+                auto node = list->pop_front();
+                if (node == nullptr) {
+                    break;
+                }
+                values.push_back(static_cast<DataNode*>(node)->m_value);
+            }
+        } while (list->m_head.load() != nullptr || !list->rearm_eventfd());
+    }
+
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    ::close(epfd);
+
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), TOTAL);
+    for (int i = 0; i < TOTAL; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+    EXPECT_LT(wakeups, TOTAL);
+}
+
+using Stats_list = ut::Lock_free_list<DataNode, ut::Concurrency::MPMC, ut::Contention_stats<>>;
+
+// Node carries only the vptr and its two links, a derived node's first
+// member goes into the padding after them
+struct PointerNode : ut::Node {
+    void* m_ptr;
+};
+static_assert(sizeof(PointerNode) == sizeof(ut::Node));
+
+// The default list pays nothing for the stats surface
+static_assert(sizeof(ut::Lock_free_list<DataNode>::iterator) == 2 * sizeof(void*));
+static_assert(sizeof(ut::Lock_free_list<DataNode>::const_iterator) == 2 * sizeof(void*));
+static_assert(!ut::Lock_free_list<DataNode>::blocking && ut::Blocking_list<DataNode>::blocking);
+
+TEST(ContentionStats, CountsUncontendedOperations) {
+    Stats_list list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < 6; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    list.push_back(nodes[0].get());
+    list.push_back(nodes[1].get());
+    list.push_front(nodes[2].get());
+    list.insert_after(nodes[0].get(), nodes[3].get());
+    list.remove(nodes[3].get());
+    EXPECT_EQ(list.find_if([](const DataNode* node) { return node->m_value == 10; }), nullptr);
+    EXPECT_EQ(list.pop_front(), nodes[2].get());
+
+    auto stats = list.stats();
+    EXPECT_EQ(stats.calls(ut::List_op::push_back), 2u);
+    EXPECT_EQ(stats.calls(ut::List_op::push_front), 1u);
+    EXPECT_EQ(stats.calls(ut::List_op::insert_after), 1u);
+    EXPECT_EQ(stats.calls(ut::List_op::remove), 1u);
+    EXPECT_EQ(stats.calls(ut::List_op::find_if), 1u);
+    EXPECT_EQ(stats.calls(ut::List_op::pop_front), 1u);
+    for (size_t op = 0; op < ut::List_stats::n_ops; ++op) {
+        EXPECT_EQ(stats.m_attempts[op], stats.m_calls[op]);
+        EXPECT_EQ(stats.m_cas_failures[op], 0u);
+    }
+    EXPECT_EQ(stats.m_remove_retries, 0u);
+    EXPECT_EQ(stats.m_tail_lags, 0u);
+
+    list.reset_stats();
+    EXPECT_EQ(list.stats().calls(ut::List_op::push_back), 0u);
+}
+
+TEST(ContentionStats, CountsIteratorRecovery) {
+    Stats_list list;
+    DataNode n1(1), n2(2), n3(3);
+    list.push_back(&n1);
+    list.push_back(&n2);
+    list.push_back(&n3);
+
+    auto it = list.begin();
+    ++it;
+    list.remove(&n1);
+    ++it;
+    EXPECT_EQ(list.stats().m_iterator_recoveries, 1u);
+
+    // Iterators of a list without stats have nowhere to count
+    ut::Lock_free_list<DataNode> plain;
+    DataNode p1(1);
+    plain.push_back(&p1);
+    EXPECT_EQ(plain.stats().m_iterator_recoveries, 0u);
+}
+
+TEST(ContentionStats, ConcurrentPushBack) {
+    static const int NUM_THREADS = 8;
+    static const int ITEMS_PER_THREAD = 5000;
+
+    Stats_list list;
+    std::vector<std::unique_ptr<DataNode>> nodes;
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list.push_back(nodes[t * ITEMS_PER_THREAD + i].get());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every retry is a CAS failure or a lagging tail
+    auto stats = list.stats();
+    EXPECT_EQ(stats.calls(ut::List_op::push_back), NUM_THREADS * ITEMS_PER_THREAD);
+    EXPECT_EQ(stats.attempts(ut::List_op::push_back) - stats.calls(ut::List_op::push_back),
+              stats.cas_failures(ut::List_op::push_back) + stats.m_tail_lags);
+}
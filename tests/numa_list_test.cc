@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <set>
+
+#include "numa_list.h"
+#include "tests/timestamp_node.h"
+
+TEST(Numa, ParseList) {
+    EXPECT_EQ(ut::numa::parse_list("0"), (std::vector<int>{0}));
+    EXPECT_EQ(ut::numa::parse_list("0-3,8,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(ut::numa::parse_list("").empty());
+}
+
+TEST(Numa, TopologyCoversEveryCpu) {
+    const auto& topology = ut::numa::Topology::get();
+    ASSERT_GE(topology.node_count(), 1);
+
+    std::set<int> cpus;
+    for (int node = 0; node < topology.node_count(); ++node) {
+        for (auto cpu : topology.cpus_of(node)) {
+            EXPECT_EQ(topology.node_of_cpu(cpu), node);
+            EXPECT_TRUE(cpus.insert(cpu).second);
+        }
+    }
+    EXPECT_FALSE(cpus.empty());
+
+    const auto node = ut::numa::current_node();
+    EXPECT_GE(node, 0);
+    EXPECT_LT(node, topology.node_count());
+}
+
+TEST(Numa, ArenaPlacesAndReusesBlocks) {
+    using Arena = ut::numa::Arena<DataNode>;
+    Arena arena;
+
+    const auto node = ut::numa::current_node();
+    auto first = arena.create(node, 1);
+    EXPECT_EQ(first->m_value, 1);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % alignof(DataNode), 0);
+
+    // Without NUMA support in the kernel there is nothing to check
+    if (auto placed = ut::numa::node_of(first); placed >= 0) {
+        EXPECT_EQ(placed, node);
+    }
+
+    // Blocks come back LIFO from the node's free list
+    arena.destroy(first);
+    auto second = arena.create(node, 2);
+    EXPECT_EQ(second, static_cast<void*>(first));
+    EXPECT_EQ(second->m_value, 2);
+
+    // Spill into a second chunk
+    std::vector<DataNode*> blocks{second};
+    for (size_t i = 0; i < Arena::chunk_size / Arena::block_size + 10; ++i) {
+        blocks.push_back(arena.create_local(int(i)));
+    }
+    std::sort(blocks.begin(), blocks.end());
+    EXPECT_EQ(std::adjacent_find(blocks.begin(), blocks.end()), blocks.end());
+
+    for (auto block : blocks) {
+        arena.destroy(block);
+    }
+}
+
+TEST(NumaShardedList, PopStealsFromOtherShards) {
+    ut::Numa_sharded_list<DataNode> list(4);
+    std::vector<std::unique_ptr<DataNode>> nodes;
+
+    for (int i = 0; i < 8; ++i) {
+        nodes.push_back(std::make_unique<DataNode>(i));
+        list.push(nodes.back().get(), i % 4);
+    }
+
+    int visited = 0;
+    list.for_each([&](DataNode&) { ++visited; });
+    EXPECT_EQ(visited, 8);
+
+    // Shard 1 is drained first, then the others in ring order
+    std::vector<int> values;
+    while (auto node = list.pop(1)) {
+        values.push_back(static_cast<DataNode*>(node)->m_value);
+    }
+    EXPECT_EQ(values, (std::vector<int>{5, 1, 6, 2, 7, 3, 4, 0}));
+}
+
+TEST(NumaShardedList, ConcurrentPushPop) {
+    static const int NUM_THREADS = 4;
+    static const int ITEMS_PER_THREAD = 5000;
+
+    ut::numa::Arena<DataNode> arena;
+    ut::Numa_sharded_list<DataNode> list(2);
+    std::vector<std::vector<DataNode*>> popped(NUM_THREADS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list.push(arena.create_local(t * ITEMS_PER_THREAD + i), t % 2);
+                if (i % 2 == 1) {
+                    if (auto node = list.pop(t % 2)) {
+                        popped[t].push_back(static_cast<DataNode*>(node));
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    for (const auto& nodes : popped) {
+        for (auto node : nodes) {
+            values.push_back(node->m_value);
+            arena.destroy(node);
+        }
+    }
+    while (auto node = list.pop()) {
+        values.push_back(static_cast<DataNode*>(node)->m_value);
+        arena.destroy(static_cast<DataNode*>(node));
+    }
+
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), NUM_THREADS * ITEMS_PER_THREAD);
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+}
@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <random>
+
+#include "striped_list.h"
+#include "tests/timestamp_node.h"
+
+// The stripe index sits in the padding after the links
+static_assert(sizeof(StripedDataNode) == sizeof(DataNode));
+
+TEST(StripedList, StripesOnOwnCacheLines) {
+    using List = ut::Striped_lock_free_list<StripedDataNode, 8>;
+
+    EXPECT_EQ(sizeof(List::Stripe), 64);
+    EXPECT_EQ(sizeof(List), 8 * 64);
+}
+
+TEST(StripedList, PushByKeyIterateRemove) {
+    ut::Striped_lock_free_list<StripedDataNode, 4> list;
+    std::vector<std::unique_ptr<StripedDataNode>> nodes;
+    EXPECT_TRUE(list.empty());
+
+    for (int i = 0; i < 100; ++i) {
+        nodes.push_back(std::make_unique<StripedDataNode>(i));
+        list.push(nodes.back().get(), i);
+    }
+
+    // Every stripe got some, iteration sees them all once
+    for (size_t i = 0; i < list.stripe_count(); ++i) {
+        EXPECT_NE(list.stripe(i).m_head.load(), nullptr);
+    }
+    std::vector<int> values;
+    for (const auto& node : list) {
+        values.push_back(node.m_value);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+
+    // Remove a first node and one from the middle of its stripe
+    auto first = list.stripe(1).m_head.load();
+    auto middle = ((ut::Node*)first)->m_next.load();
+    list.remove(middle);
+    list.remove(first);
+    EXPECT_EQ(list.size(), 98);
+
+    auto found = list.find_if([](const StripedDataNode* node) { return node->m_value == 50; });
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(static_cast<StripedDataNode*>(found)->m_value, 50);
+}
+
+TEST(StripedList, PopProbesAllStripes) {
+    ut::Striped_lock_free_list<StripedDataNode, 4> list;
+    std::vector<std::unique_ptr<StripedDataNode>> nodes;
+
+    for (int i = 0; i < 4; ++i) {
+        nodes.push_back(std::make_unique<StripedDataNode>(i));
+        list.stripe(i).push_front(nodes.back().get());
+    }
+
+    std::vector<int> values;
+    while (auto node = list.pop()) {
+        values.push_back(static_cast<StripedDataNode*>(node)->m_value);
+    }
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(values, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(StripedList, ConcurrentPushPop) {
+    static const int NUM_THREADS = 8;
+    static const int ITEMS_PER_THREAD = 2000;
+
+    ut::Striped_lock_free_list<StripedDataNode, 4> list;
+    std::vector<std::unique_ptr<StripedDataNode>> nodes;
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        nodes.push_back(std::make_unique<StripedDataNode>(i));
+    }
+
+    std::vector<std::vector<int>> popped(NUM_THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list.push(nodes[t * ITEMS_PER_THREAD + i].get());
+                if (i % 3 == 0) {
+                    if (auto node = list.pop()) {
+                        popped[t].push_back(static_cast<StripedDataNode*>(node)->m_value);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<int> values;
+    for (const auto& v : popped) {
+        values.insert(values.end(), v.begin(), v.end());
+    }
+    for (const auto& node : list) {
+        values.push_back(node.m_value);
+    }
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), NUM_THREADS * ITEMS_PER_THREAD);
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+TEST(StripedList, RemoveFindsStripeOfAnyThread) {
+    static const int NUM_THREADS = 6;
+    static const int ITEMS_PER_THREAD = 500;
+
+    ut::Striped_lock_free_list<StripedDataNode, 4> list;
+    std::vector<std::unique_ptr<StripedDataNode>> nodes;
+    for (int i = 0; i < NUM_THREADS * ITEMS_PER_THREAD; ++i) {
+        nodes.push_back(std::make_unique<StripedDataNode>(i));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list.push(nodes[t * ITEMS_PER_THREAD + i].get());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Removed from another thread, remove() goes to the stripe each was pushed to
+    std::mt19937 rng(7);
+    std::shuffle(nodes.begin(), nodes.end(), rng);
+    for (auto& node : nodes) {
+        EXPECT_LT(node->m_stripe, list.stripe_count());
+        EXPECT_EQ(&list.stripe_of(node.get()), &list.stripe(node->m_stripe));
+        list.remove(node.get());
+    }
+    EXPECT_TRUE(list.empty());
+}
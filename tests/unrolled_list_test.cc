@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "unrolled_list.h"
+
+struct Handle {
+    uint64_t m_id;
+    uint64_t m_generation;
+
+    bool operator==(const Handle&) const = default;
+};
+
+TEST(UnrolledList, ChunkFitsCacheLine) {
+    using IntList = ut::Unrolled_list<int>;
+    using HandleList = ut::Unrolled_list<Handle>;
+
+    EXPECT_EQ(sizeof(IntList::Chunk), 64);
+    EXPECT_EQ(sizeof(HandleList::Chunk), 64);
+    EXPECT_EQ(IntList::slots, 11);
+    EXPECT_EQ(HandleList::slots, 2);
+}
+
+TEST(UnrolledList, PushIterateRemove) {
+    ut::Unrolled_list<int> list;
+    EXPECT_TRUE(list.empty());
+
+    for (int i = 0; i < 100; ++i) {
+        list.push(i);
+    }
+
+    EXPECT_EQ(list.size(), 100);
+    EXPECT_EQ(list.chunk_count(), (100 + decltype(list)::slots - 1) / decltype(list)::slots);
+
+    std::vector<int> values(list.begin(), list.end());
+    std::sort(values.begin(), values.end());
+    ASSERT_EQ(values.size(), 100);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+
+    EXPECT_TRUE(list.remove(42));
+    EXPECT_FALSE(list.remove(42));
+    EXPECT_EQ(list.size(), 99);
+
+    int found = -1;
+    EXPECT_FALSE(list.find_if([](int v) { return v == 42; }, found));
+    EXPECT_TRUE(list.find_if([](int v) { return v == 43; }, found));
+    EXPECT_EQ(found, 43);
+}
+
+TEST(UnrolledList, FreedSlotsAreReused) {
+    ut::Unrolled_list<int> list;
+
+    for (int i = 0; i < 1000; ++i) {
+        list.push(i);
+    }
+    const auto chunks = list.chunk_count();
+
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 100; ++i) {
+            int value;
+            ASSERT_TRUE(list.try_pop(value));
+        }
+        for (int i = 0; i < 100; ++i) {
+            list.push(i);
+        }
+    }
+
+    EXPECT_EQ(list.size(), 1000);
+    EXPECT_EQ(list.chunk_count(), chunks);
+}
+
+TEST(UnrolledList, ConcurrentPushPop) {
+    static const int NUM_THREADS = 4;
+    static const int ITEMS_PER_THREAD = 5000;
+
+    ut::Unrolled_list<Handle> list;
+    std::vector<std::vector<Handle>> popped(NUM_THREADS);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < NUM_THREADS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < ITEMS_PER_THREAD; ++i) {
+                list.push(Handle{uint64_t(t * ITEMS_PER_THREAD + i), 1});
+                if (i % 2 == 1) {
+                    Handle handle;
+                    if (list.try_pop(handle)) {
+                        popped[t].push_back(handle);
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint64_t> ids;
+    for (const auto& handles : popped) {
+        for (const auto& handle : handles) {
+            ids.push_back(handle.m_id);
+        }
+    }
+    for (const auto& handle : list) {
+        ids.push_back(handle.m_id);
+    }
+
+    // Every value is either still in the list or was popped, exactly once
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(ids.size(), NUM_THREADS * ITEMS_PER_THREAD);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        EXPECT_EQ(ids[i], i);
+    }
+}
+
+// Slots are recycled while readers copy them, every value a reader gets
+// must be one that was pushed whole
+TEST(UnrolledList, ReadersNeverSeeTornValues) {
+    static const int NUM_WRITERS = 2;
+    static const int NUM_READERS = 2;
+    static const int OPS = 20000;
+
+    ut::Unrolled_list<Handle> list;
+    for (uint64_t i = 0; i < 64; ++i) {
+        list.push(Handle{i, ~i});
+    }
+
+    std::atomic<int> writers_done{0};
+    std::atomic<int> torn{0};
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < NUM_WRITERS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (uint64_t i = 0; i < OPS; ++i) {
+                Handle handle;
+                if (list.try_pop(handle)) {
+                    torn += handle.m_generation != ~handle.m_id;
+                }
+                const uint64_t id = (uint64_t(t) << 32) | i;
+                list.push(Handle{id, ~id});
+            }
+            writers_done.fetch_add(1);
+        });
+    }
+
+    for (int t = 0; t < NUM_READERS; ++t) {
+        threads.emplace_back([&]() {
+            while (writers_done.load() < NUM_WRITERS) {
+                for (const auto& handle : list) {
+                    torn += handle.m_generation != ~handle.m_id;
+                }
+                Handle found;
+                if (list.find_if([](const Handle& h) { return h.m_id % 7 == 3; }, found)) {
+                    torn += found.m_generation != ~found.m_id;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(list.size(), 64);
+}
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "work_stealing.h"
+
+namespace {
+
+struct Counting_task : ut::Task {
+    explicit Counting_task(std::atomic<int>* counter)
+        : m_counter(counter) {}
+
+    void execute() override {
+        m_counter->fetch_add(1);
+    }
+
+    std::atomic<int>* m_counter;
+};
+
+// Fork/join fib: spawn fib(n - 1), compute fib(n - 2) inline, then help
+// until the child is done
+struct Fib_task : ut::Task {
+    Fib_task(ut::Work_stealing_pool& pool, int n)
+        : m_pool(pool), m_n(n) {}
+
+    void execute() override {
+        m_result = fib(m_pool, m_n);
+        m_done.store(true, std::memory_order_release);
+    }
+
+    static uint64_t fib(ut::Work_stealing_pool& pool, int n) {
+        if (n < 2) {
+            return n;
+        }
+        Fib_task child(pool, n - 1);
+        pool.submit(&child);
+        const auto other = fib(pool, n - 2);
+        pool.wait_until([&child] { return child.m_done.load(std::memory_order_acquire); });
+        return child.m_result + other;
+    }
+
+    ut::Work_stealing_pool& m_pool;
+    int m_n;
+    uint64_t m_result{};
+    std::atomic<bool> m_done{false};
+};
+
+} // namespace
+
+TEST(WorkStealing, StealHalfSplitsChain) {
+    ut::Work_stealing_pool::Worker victim;
+    ut::Work_stealing_pool::Worker thief;
+    std::atomic<int> counter{0};
+    std::vector<std::unique_ptr<Counting_task>> tasks;
+
+    for (int i = 0; i < 5; ++i) {
+        tasks.push_back(std::make_unique<Counting_task>(&counter));
+        victim.m_tasks.push_back(tasks.back().get());
+    }
+
+    // Victim keeps the two newest, the thief runs the oldest and queues two
+    auto task = ut::Work_stealing_pool::steal_half(victim, thief);
+    EXPECT_EQ(task, tasks[4].get());
+
+    std::vector<ut::Task*> kept;
+    for (auto& t : victim.m_tasks) {
+        kept.push_back(&t);
+    }
+    EXPECT_EQ(kept, (std::vector<ut::Task*>{tasks[0].get(), tasks[1].get()}));
+
+    std::vector<ut::Task*> stolen;
+    for (auto& t : thief.m_tasks) {
+        stolen.push_back(&t);
+    }
+    EXPECT_EQ(stolen, (std::vector<ut::Task*>{tasks[2].get(), tasks[3].get()}));
+}
+
+TEST(WorkStealing, StealHalfIgnoresStaleBackLinks) {
+    ut::Work_stealing_pool::Worker victim;
+    ut::Work_stealing_pool::Worker thief;
+    std::atomic<int> counter{0};
+    std::vector<std::unique_ptr<Counting_task>> tasks;
+
+    for (int i = 0; i < 5; ++i) {
+        tasks.push_back(std::make_unique<Counting_task>(&counter));
+        victim.m_tasks.push_back(tasks.back().get());
+    }
+
+    // As left by a remove() that lost the race to fix the back link
+    tasks[4]->m_prev.store(ut::Node::Tag{tasks[1].get(), 0});
+
+    EXPECT_EQ(ut::Work_stealing_pool::steal_half(victim, thief), tasks[4].get());
+
+    std::vector<ut::Task*> stolen;
+    for (auto& t : thief.m_tasks) {
+        stolen.push_back(&t);
+    }
+    EXPECT_EQ(stolen, (std::vector<ut::Task*>{tasks[2].get(), tasks[3].get()}));
+
+    std::vector<ut::Task*> kept;
+    for (auto& t : victim.m_tasks) {
+        kept.push_back(&t);
+    }
+    EXPECT_EQ(kept, (std::vector<ut::Task*>{tasks[0].get(), tasks[1].get()}));
+}
+
+TEST(WorkStealing, StealLeavesOwnersFrontInPlace) {
+    ut::Work_stealing_pool::Worker victim;
+    ut::Work_stealing_pool::Worker thief;
+    std::atomic<int> counter{0};
+    std::vector<std::unique_ptr<Counting_task>> tasks;
+
+    for (int i = 0; i < 6; ++i) {
+        tasks.push_back(std::make_unique<Counting_task>(&counter));
+        victim.m_tasks.push_front(tasks.back().get());
+    }
+
+    // An owner pop that read the head and its successor before the steal
+    auto head = victim.m_tasks.m_head.load();
+    auto next = ((ut::Node*)head)->m_next.load();
+
+    EXPECT_EQ(ut::Work_stealing_pool::steal_half(victim, thief), tasks[0].get());
+
+    // The newest stay at the front, only the head's version moved
+    EXPECT_EQ((ut::Node*)victim.m_tasks.m_head.load(), (ut::Node*)head);
+    EXPECT_FALSE(victim.m_tasks.m_head.compare_exchange_strong(head, head.next_version().with_ptr(next)));
+
+    std::vector<ut::Task*> kept;
+    while (auto task = victim.m_tasks.pop_front()) {
+        kept.push_back(static_cast<ut::Task*>(task));
+    }
+    EXPECT_EQ(kept, (std::vector<ut::Task*>{tasks[5].get(), tasks[4].get(), tasks[3].get()}));
+
+    std::vector<ut::Task*> stolen;
+    for (auto& t : thief.m_tasks) {
+        stolen.push_back(&t);
+    }
+    EXPECT_EQ(stolen, (std::vector<ut::Task*>{tasks[2].get(), tasks[1].get()}));
+}
+
+TEST(WorkStealing, StealTakesTheOnlyTask) {
+    ut::Work_stealing_pool::Worker victim;
+    ut::Work_stealing_pool::Worker thief;
+    std::atomic<int> counter{0};
+    Counting_task task(&counter);
+
+    victim.m_tasks.push_front(&task);
+
+    EXPECT_EQ(ut::Work_stealing_pool::steal_half(victim, thief), &task);
+    EXPECT_EQ(victim.m_tasks.pop_front(), nullptr);
+    EXPECT_EQ(thief.m_tasks.pop_front(), nullptr);
+    EXPECT_EQ(ut::Work_stealing_pool::steal_half(victim, thief), nullptr);
+}
+
+TEST(WorkStealing, RunsEverySubmittedTask) {
+    static const int NUM_TASKS = 10000;
+
+    std::atomic<int> counter{0};
+    std::vector<std::unique_ptr<Counting_task>> tasks;
+    for (int i = 0; i < NUM_TASKS; ++i) {
+        tasks.push_back(std::make_unique<Counting_task>(&counter));
+    }
+
+    ut::Work_stealing_pool pool(4);
+    for (auto& task : tasks) {
+        pool.submit(task.get());
+    }
+    pool.wait_until([&counter] { return counter.load() == NUM_TASKS; });
+
+    // Workers count a task after it ran, so the total may still lag
+    auto executed = [&pool] {
+        uint64_t n = 0;
+        for (size_t i = 0; i < pool.worker_count(); ++i) {
+            n += pool.worker(i).m_executed.load();
+        }
+        return n;
+    };
+    pool.wait_until([&] { return executed() >= NUM_TASKS; });
+    EXPECT_EQ(executed(), NUM_TASKS);
+    EXPECT_EQ(counter.load(), NUM_TASKS);
+}
+
+TEST(WorkStealing, ForkJoinFib) {
+    ut::Work_stealing_pool pool(4);
+    Fib_task root(pool, 20);
+
+    pool.submit(&root);
+    pool.wait_until([&root] { return root.m_done.load(); });
+    EXPECT_EQ(root.m_result, 6765);
+}
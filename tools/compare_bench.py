@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""Compare two Google Benchmark JSON runs and flag regressions.
+
+Run the benchmarks with repetitions so there is a distribution to test:
+
+    ./lockfreelist_bench --benchmark_repetitions=10 \\
+        --benchmark_out=old.json --benchmark_out_format=json
+    ...
+    tools/compare_bench.py old.json new.json
+
+For every benchmark in both runs the tool compares real time, items and
+bytes per second, the latency (*_ns) and per-operation (*/op) counters, and
+the memory counters of memory_bench (*/elem and fragmentation).
+A metric regresses if its median got worse by more than --threshold and a
+two-sided Mann-Whitney U test rejects equal distributions at --alpha.
+Without enough repetitions on both sides only the change is shown. Exits
+with 1 if anything regressed, so it can gate a nightly job.
+"""
+
+import argparse
+import json
+import math
+import re
+import statistics
+import sys
+
+TIME_UNITS_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+# Fewest repetitions per side for which the test can reach alpha = 0.05
+MIN_SAMPLES = 4
+
+
+def load(path):
+    """Context and {benchmark name: {metric: [samples]}} of one run"""
+    with open(path) as f:
+        data = json.load(f)
+
+    runs = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("run_type") == "aggregate" or bench.get("error_occurred"):
+            continue
+
+        name = bench.get("run_name", bench["name"])
+        metrics = runs.setdefault(name, {})
+        scale = TIME_UNITS_NS.get(bench.get("time_unit", "ns"), 1.0)
+
+        metrics.setdefault("real_time_ns", []).append(bench["real_time"] * scale)
+
+        for key, value in bench.items():
+            if direction(key) != 0 and isinstance(value, (int, float)):
+                metrics.setdefault(key, []).append(float(value))
+
+    return data.get("context", {}), runs
+
+
+def direction(metric):
+    """+1 if higher is better, -1 if lower is better, 0 if not compared"""
+    if metric.endswith("_per_second"):
+        return 1
+    if metric == "real_time_ns" or metric.endswith("_ns") or metric.endswith("/op"):
+        return -1
+    if metric.endswith("/elem") or metric == "fragmentation":
+        return -1
+    return 0
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, normal approximation
+    with tie and continuity correction"""
+    n1, n2 = len(a), len(b)
+    ranked = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(ranked)
+    ties = 0.0
+
+    i = 0
+    while i < len(ranked):
+        j = i
+        while j + 1 < len(ranked) and ranked[j + 1][0] == ranked[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        t = j - i + 1
+        ties += t ** 3 - t
+        i = j + 1
+
+    r1 = sum(rank for rank, (_, side) in zip(ranks, ranked) if side == 0)
+    u = r1 - n1 * (n1 + 1) / 2.0
+    mean = n1 * n2 / 2.0
+    n = n1 + n2
+    var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1)))
+
+    if var <= 0:
+        return 1.0
+
+    z = (abs(u - mean) - 0.5) / math.sqrt(var)
+    return max(0.0, min(1.0, math.erfc(max(z, 0.0) / math.sqrt(2))))
+
+
+def describe_context(old, new):
+    keys = ["cpu_model", "cpu_cores", "compiler", "build_type", "cxx_flags", "tag_mode", "library_build_type"]
+    lines = []
+    for key in keys:
+        a, b = old.get(key), new.get(key)
+        if a is None and b is None:
+            continue
+        mark = "" if a == b else "   <-- differs"
+        lines.append(f"  {key:18} {a} | {b}{mark}")
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("old", help="baseline JSON from --benchmark_out")
+    parser.add_argument("new", help="candidate JSON from --benchmark_out")
+    parser.add_argument("--alpha", type=float, default=0.05, help="significance level (default 0.05)")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="smallest relative change of the median that counts (default 0.05)")
+    parser.add_argument("--filter", default="", help="only benchmarks matching this regex")
+    parser.add_argument("--all", action="store_true", help="show unchanged metrics too")
+    args = parser.parse_args()
+
+    old_context, old_runs = load(args.old)
+    new_context, new_runs = load(args.new)
+    pattern = re.compile(args.filter)
+
+    print("Context (old | new):")
+    for line in describe_context(old_context, new_context):
+        print(line)
+    print()
+
+    header = f"{'benchmark':60} {'metric':24} {'old':>12} {'new':>12} {'change':>8} {'p':>7}  verdict"
+    print(header)
+    print("-" * len(header))
+
+    regressions = 0
+    untested = 0
+
+    for name in sorted(set(old_runs) & set(new_runs)):
+        if not pattern.search(name):
+            continue
+
+        for metric in sorted(set(old_runs[name]) & set(new_runs[name])):
+            a, b = old_runs[name][metric], new_runs[name][metric]
+            old_median, new_median = statistics.median(a), statistics.median(b)
+
+            if old_median == 0:
+                continue
+
+            change = (new_median - old_median) / old_median
+            worse = -change * direction(metric)
+            testable = len(a) >= MIN_SAMPLES and len(b) >= MIN_SAMPLES
+            p = mann_whitney_p(a, b) if testable else None
+
+            if abs(change) < args.threshold:
+                verdict = ""
+            elif not testable:
+                verdict = "worse?" if worse > 0 else "better?"
+                untested += 1
+            elif p < args.alpha:
+                verdict = "REGRESSION" if worse > 0 else "improved"
+                regressions += worse > 0
+            else:
+                verdict = "noise"
+
+            if verdict or args.all:
+                p_text = f"{p:.3f}" if p is not None else "-"
+                print(f"{name[:60]:60} {metric[:24]:24} {old_median:12.4g} {new_median:12.4g} "
+                      f"{change:+8.1%} {p_text:>7}  {verdict}")
+
+    missing = sorted(set(old_runs) ^ set(new_runs))
+    if missing:
+        print(f"\n{len(missing)} benchmarks are only in one run")
+
+    if untested:
+        print(f"\n{untested} changes not tested, rerun with --benchmark_repetitions={2 * MIN_SAMPLES} or more")
+
+    print(f"\n{regressions} significant regressions")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())